@@ -1,7 +1,43 @@
 #ifndef __ASM_H_
 #define __ASM_H_
 
+/* SVC numbers, encoded as the immediate of the svc instruction */
+#define SVC_YIELD	0
+#define SVC_URING_ENTER	1
+#define SVC_EXIT	2
+#define SVC_WAIT_PERIOD	3
+#define SVC_NOTIFY	4
+#define SVC_SEM		5
+#define SVC_MUTEX	6
+#define SVC_TASK	7
+#define SVC_CYCLES	8	/* answered by svc_handler itself */
+
+/* Why the last activate() came back to the kernel */
+#define TRAP_SVC	1
+#define TRAP_TICK	2
+#define TRAP_WAKE	3	/* an ISR woke a task, see sched_preempt_from_isr() */
+
+#ifndef __ASSEMBLER__
+
+struct uring;
+struct semaphore;
+struct mutex;
+struct Task;
+
 unsigned int *activate(unsigned int *stack);
 void syscall(void);
+void task_exit(void);
+void task_wait_next_period(void);
+int uring_enter(struct uring *ring, unsigned int wait_nr);
+unsigned int notify_call(unsigned int op, unsigned int arg0, unsigned int arg1);
+int sem_call(unsigned int op, struct semaphore *sem, unsigned int timeout);
+void mutex_call(unsigned int op, struct mutex *mutex);
+void task_call(unsigned int op, struct Task *task, unsigned int value);
+unsigned int cycles_call(void);
+
+extern volatile unsigned int trap_source;
+extern volatile unsigned int pendsv_tick;
+
+#endif
 
 #endif
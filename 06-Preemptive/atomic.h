@@ -0,0 +1,108 @@
+#ifndef __ATOMIC_H_
+#define __ATOMIC_H_
+
+/*
+ * Atomic operations on 32-bit words for the Cortex-M3, built on LDREX/STREX.
+ * The exclusive monitor is cleared on every exception entry and return, so
+ * an operation interrupted by an ISR or a context switch simply retries;
+ * nothing here disables interrupts. Read-modify-write operations return the
+ * previous value and are unordered, combine them with the fences below.
+ */
+
+static inline void atomic_fence(void)
+{
+	__asm__ __volatile__("dmb" ::: "memory");
+}
+
+/* Later accesses stay after an acquiring load or operation */
+static inline void atomic_acquire(void)
+{
+	atomic_fence();
+}
+
+/* Earlier accesses complete before a releasing store or operation */
+static inline void atomic_release(void)
+{
+	atomic_fence();
+}
+
+static inline unsigned int atomic_ldrex(volatile unsigned int *ptr)
+{
+	unsigned int val;
+
+	__asm__ __volatile__("ldrex %0, [%1]" : "=r" (val) : "r" (ptr) : "memory");
+	return val;
+}
+
+/* Returns 0 when the store went through */
+static inline unsigned int atomic_strex(volatile unsigned int *ptr, unsigned int val)
+{
+	unsigned int fail;
+
+	__asm__ __volatile__("strex %0, %2, [%1]" : "=&r" (fail) : "r" (ptr), "r" (val) : "memory");
+	return fail;
+}
+
+static inline void atomic_clrex(void)
+{
+	__asm__ __volatile__("clrex" ::: "memory");
+}
+
+static inline unsigned int atomic_load_acquire(volatile unsigned int *ptr)
+{
+	unsigned int val = *ptr;
+
+	atomic_acquire();
+	return val;
+}
+
+static inline void atomic_store_release(volatile unsigned int *ptr, unsigned int val)
+{
+	atomic_release();
+	*ptr = val;
+}
+
+/* Store `desired` if *ptr holds `expected`, returns the value seen */
+static inline unsigned int atomic_cas(volatile unsigned int *ptr, unsigned int expected, unsigned int desired)
+{
+	unsigned int old;
+
+	do {
+		old = atomic_ldrex(ptr);
+		if (old != expected) {
+			atomic_clrex();
+			return old;
+		}
+	} while (atomic_strex(ptr, desired));
+	return old;
+}
+
+#define ATOMIC_FETCH_OP(name, op)						\
+static inline unsigned int atomic_fetch_##name(volatile unsigned int *ptr, unsigned int val)	\
+{										\
+	unsigned int old;							\
+										\
+	do {									\
+		old = atomic_ldrex(ptr);					\
+	} while (atomic_strex(ptr, old op val));				\
+	return old;								\
+}
+
+ATOMIC_FETCH_OP(add, +)
+ATOMIC_FETCH_OP(sub, -)
+ATOMIC_FETCH_OP(or, |)
+ATOMIC_FETCH_OP(and, &)
+
+#undef ATOMIC_FETCH_OP
+
+static inline unsigned int atomic_exchange(volatile unsigned int *ptr, unsigned int val)
+{
+	unsigned int old;
+
+	do {
+		old = atomic_ldrex(ptr);
+	} while (atomic_strex(ptr, val));
+	return old;
+}
+
+#endif
@@ -0,0 +1,428 @@
+#include <stdint.h>
+#include <string.h>
+#include "reg.h"
+#include "asm.h"
+#include "os.h"
+#include "notify.h"
+#include "sem.h"
+#include "mutex.h"
+#include "atomic.h"
+#include "mpmc.h"
+#include "heap.h"
+#include "pool.h"
+#include "workqueue.h"
+#include "swtimer.h"
+#include "clock.h"
+#include "usart.h"
+#include "bench.h"
+
+/*
+ * Micro-benchmarks of kernel primitives, built with `make BENCH=1` and run
+ * as a task so every measured call pays its real trap and scheduler cost.
+ * Time comes from the SysTick down-counter combined with os_ticks, read
+ * through clock_now(): each read is one short SVC, a constant few dozen
+ * cycles that BENCH_ROUNDS spreads thin.
+ */
+
+/* Core cycles since the scheduler started, the governor is off in BENCH
+ * builds so the profile never changes under a measurement */
+unsigned int bench_cycles(void)
+{
+	return clock_now();
+}
+
+void bench_report(const char *name, unsigned int cycles, unsigned int rounds)
+{
+	print_str("bench: ");
+	print_str(name);
+	print_str(" ");
+	print_int(cycles / rounds);
+	print_str(" cycles/op\n");
+}
+
+static mutex_t bench_mutex;
+static unsigned int bench_id;
+
+/* Items worker i moves in the current MPMC round */
+static unsigned int worker_items[BENCH_WORKERS];
+
+POOL_DEFINE(bench_pool, POOL_BENCH_SIZE, POOL_BENCH_BLOCKS);
+
+static struct mpmc_cell bench_cells[MPMC_BENCH_SIZE];
+static mpmc_t bench_queue;
+static volatile unsigned int mpmc_sum;
+
+static const struct {
+	unsigned int producers;
+	unsigned int consumers;
+	const char *name;
+} mpmc_configs[] = {
+	{ 1, 1, "mpmc 1P/1C push+pop" },
+	{ 2, 2, "mpmc 2P/2C push+pop" },
+	{ 1, 3, "mpmc 1P/3C push+pop" },
+	{ 3, 1, "mpmc 3P/1C push+pop" },
+};
+
+static volatile unsigned int stress_counter;
+static volatile unsigned int stress_cas_counter;
+static volatile unsigned int stress_bits;
+static volatile unsigned int stress_errors;
+
+static unsigned int self(void)
+{
+	size_t i;
+
+	for (i = 0; i < nr_tasks; i++) {
+		if (user_task[i].state == RUNNING)
+			return i;
+	}
+	return 0;
+}
+
+/* A yield with every worker blocked: one trap plus one scheduler pass that
+ * picks us again, and the kernel's own figure for the pass alone */
+static void bench_yield(void)
+{
+	unsigned int start;
+	int i;
+
+	start = bench_cycles();
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		syscall();
+	bench_report("yield round trip (scheduler pass)", bench_cycles() - start, BENCH_ROUNDS);
+	print_str("bench: scheduler pass ");
+	print_int(sched_stats.pass_cycles_last);
+	print_str(" cycles, max ");
+	print_int(sched_stats.pass_cycles_max);
+	print_str("\n");
+}
+
+static void bench_notify(void)
+{
+	unsigned int me = self();
+	unsigned int start;
+	int i;
+
+	start = bench_cycles();
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		notify_give(me);
+		notify_take(0, 0);
+	}
+	bench_report("notify give+take", bench_cycles() - start, BENCH_ROUNDS);
+}
+
+static void bench_sem(void)
+{
+	semaphore_t sem;
+	unsigned int start;
+	int i;
+
+	sem_init(&sem, 0);
+	start = bench_cycles();
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		sem_give(&sem);
+		sem_take(&sem, 0);
+	}
+	bench_report("semaphore give+take", bench_cycles() - start, BENCH_ROUNDS);
+}
+
+static void bench_mutex_uncontended(void)
+{
+	unsigned int start;
+	int i;
+
+	mutex_init(&bench_mutex);
+	start = bench_cycles();
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		mutex_lock(&bench_mutex);
+		mutex_unlock(&bench_mutex);
+	}
+	bench_report("mutex lock+unlock, uncontended", bench_cycles() - start, BENCH_ROUNDS);
+}
+
+/* Each round worker 0 blocks on the mutex we hold, then we time the
+ * unlock that traps and hands the lock over */
+static void bench_mutex_contended(void)
+{
+	unsigned int cycles = 0;
+	unsigned int start;
+	int i;
+
+	mutex_init(&bench_mutex);
+	for (i = 0; i < BENCH_ROUNDS / 10; i++) {
+		mutex_lock(&bench_mutex);
+		notify_overwrite(bench_id + 1, BENCH_CMD_MUTEX);
+		while (bench_mutex.word != 2)
+			syscall();
+		start = bench_cycles();
+		mutex_unlock(&bench_mutex);
+		cycles += bench_cycles() - start;
+		notify_take(0, NOTIFY_FOREVER);
+	}
+	bench_report("mutex unlock with handoff, contended", cycles, BENCH_ROUNDS / 10);
+}
+
+/* One side of the atomics stress test, `bit` is owned by the caller only */
+static void stress(unsigned int bit)
+{
+	unsigned int old;
+	int i;
+
+	for (i = 0; i < STRESS_ROUNDS; i++) {
+		atomic_fetch_add(&stress_counter, 2);
+		atomic_fetch_sub(&stress_counter, 1);
+
+		do {
+			old = stress_cas_counter;
+		} while (atomic_cas(&stress_cas_counter, old, old + 1) != old);
+
+		if (atomic_fetch_or(&stress_bits, bit) & bit)
+			atomic_fetch_add(&stress_errors, 1);
+		if (!(atomic_fetch_and(&stress_bits, ~bit) & bit))
+			atomic_fetch_add(&stress_errors, 1);
+	}
+}
+
+/* bench_task and worker 0 hammer the same words while ticks preempt them */
+static void bench_atomic_stress(void)
+{
+	unsigned int start = bench_cycles();
+
+	atomic_exchange(&stress_counter, 0);
+	atomic_exchange(&stress_cas_counter, 0);
+	atomic_exchange(&stress_bits, 0);
+	atomic_exchange(&stress_errors, 0);
+
+	notify_overwrite(bench_id + 1, BENCH_CMD_STRESS);
+	stress(1);
+	notify_take(0, NOTIFY_FOREVER);
+
+	bench_report("atomic stress round", bench_cycles() - start, 2 * STRESS_ROUNDS);
+	if (stress_counter == 2 * STRESS_ROUNDS && stress_cas_counter == 2 * STRESS_ROUNDS &&
+	    !stress_bits && !stress_errors)
+		print_str("bench: atomic stress PASS\n");
+	else
+		print_str("bench: atomic stress FAIL\n");
+}
+
+/*
+ * Replace random slots of a pool of live blocks with blocks of a random
+ * size, so the heap is fragmented while we time it. The worst case matters
+ * as much as the average here.
+ */
+static void bench_heap(void)
+{
+	void *slots[HEAP_BENCH_SLOTS] = { 0 };
+	unsigned int seed = 1;
+	unsigned int cycles = 0;
+	unsigned int worst = 0;
+	unsigned int start, elapsed;
+	tlsf_stats_t stats;
+	int i, slot;
+
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		seed = seed * 1103515245 + 12345;
+		slot = (seed >> 16) % HEAP_BENCH_SLOTS;
+		start = bench_cycles();
+		heap_free(slots[slot]);
+		slots[slot] = heap_malloc(8 + (seed >> 8) % 500);
+		elapsed = bench_cycles() - start;
+		cycles += elapsed;
+		if (elapsed > worst)
+			worst = elapsed;
+	}
+	bench_report("heap free+malloc", cycles, BENCH_ROUNDS);
+	bench_report("heap free+malloc, worst", worst, 1);
+
+	heap_get_stats(&stats);
+	print_str("bench: heap peak ");
+	print_int(stats.peak_used_bytes);
+	print_str(" of ");
+	print_int(stats.pool_bytes);
+	print_str(" bytes, fragmentation ");
+	print_int(stats.fragmentation);
+	print_str(" per mille, failures ");
+	print_int(stats.failures);
+	print_str("\n");
+
+	for (i = 0; i < HEAP_BENCH_SLOTS; i++)
+		heap_free(slots[i]);
+}
+
+static void bench_work_func(struct work *work)
+{
+	notify_give(bench_id);
+}
+
+static struct work bench_work = WORK_INIT(bench_work_func);
+
+/* Queue to execution latency through the worker task, one item at a time */
+static void bench_workqueue(void)
+{
+	int i;
+
+	for (i = 0; i < BENCH_ROUNDS / 10; i++) {
+		work_queue(&bench_work);
+		notify_take(1, NOTIFY_FOREVER);
+	}
+	print_str("bench: work queue latency avg ");
+	print_int(workqueue_stats.latency_avg);
+	print_str(" max ");
+	print_int(workqueue_stats.latency_max);
+	print_str(" cycles\n");
+}
+
+static void bench_timer_func(swtimer_t *timer)
+{
+	notify_give(bench_id);
+}
+
+/* A one-tick periodic timer, checking the daemon keeps up with it */
+static void bench_swtimer(void)
+{
+	swtimer_t *timer = swtimer_create("bench", 1, 1, bench_timer_func, NULL);
+	int i;
+
+	if (!timer) {
+		print_str("bench: swtimer create failed\n");
+		return;
+	}
+	swtimer_start(timer);
+	for (i = 0; i < SWTIMER_BENCH_EXPIRIES; i++)
+		notify_take(1, NOTIFY_FOREVER);
+	swtimer_delete(timer);
+
+	print_str("bench: swtimer latency max ");
+	print_int(swtimer_stats.latency_max);
+	print_str(" ticks, callback max ");
+	print_int(swtimer_stats.run_cycles_max);
+	print_str(" cycles, missed ");
+	print_int(swtimer_stats.missed);
+	print_str("\n");
+}
+
+/* Polled TX throughput at the configured line rate */
+static void bench_usart(void)
+{
+	const char *line = "bench: usart 0123456789abcdefghijklmnopqrstuvwxyz0123456789\n";
+	unsigned int bytes = 0;
+	unsigned int start;
+	int i;
+
+	usart_flush();
+	start = bench_cycles();
+	for (i = 0; i < 8; i++) {
+		usart_write(line);
+		bytes += strlen(line);
+	}
+	usart_flush();
+	bench_report("usart tx per byte", bench_cycles() - start, bytes);
+
+	print_str("bench: usart ");
+	print_int(usart_baud());
+	print_str(" baud, error ");
+	print_int(usart_baud_error());
+	print_str(" per mille, tx stalls ");
+	print_int(usart_stats.tx_stalls);
+	print_str("\n");
+}
+
+/* Time alloc+free pairs, then drain the pool once to check the counters */
+static void bench_pool_alloc(void)
+{
+	void *blocks[POOL_BENCH_BLOCKS + 1];
+	unsigned int start;
+	int i;
+
+	start = bench_cycles();
+	for (i = 0; i < BENCH_ROUNDS; i++)
+		pool_free(&bench_pool, pool_alloc(&bench_pool));
+	bench_report("pool alloc+free", bench_cycles() - start, BENCH_ROUNDS);
+
+	for (i = 0; i <= POOL_BENCH_BLOCKS; i++)
+		blocks[i] = pool_alloc(&bench_pool);
+	for (i = 0; i <= POOL_BENCH_BLOCKS; i++)
+		pool_free(&bench_pool, blocks[i]);
+
+	print_str("bench: pool high water ");
+	print_int(bench_pool.high_water);
+	print_str(" of ");
+	print_int(bench_pool.nr_blocks);
+	print_str(", failures ");
+	print_int(bench_pool.failures);
+	print_str("\n");
+}
+
+/* Move MPMC_BENCH_ITEMS words through the queue with the first producers
+ * workers pushing and the next consumers workers popping, all preemptible */
+static void bench_mpmc(unsigned int producers, unsigned int consumers, const char *name)
+{
+	unsigned int per_producer = MPMC_BENCH_ITEMS / producers;
+	unsigned int start;
+	unsigned int w;
+
+	mpmc_init(&bench_queue, bench_cells, MPMC_BENCH_SIZE);
+	mpmc_sum = 0;
+	start = bench_cycles();
+	for (w = 0; w < producers + consumers; w++) {
+		worker_items[w] = w < producers ? per_producer : MPMC_BENCH_ITEMS / consumers;
+		notify_overwrite(bench_id + 1 + w, w < producers ? BENCH_CMD_PRODUCE : BENCH_CMD_CONSUME);
+	}
+	for (w = 0; w < producers + consumers; w++)
+		notify_take(0, NOTIFY_FOREVER);
+	bench_report(name, bench_cycles() - start, MPMC_BENCH_ITEMS);
+
+	if (mpmc_sum != producers * per_producer * (per_producer + 1) / 2)
+		print_str("bench: mpmc lost or duplicated items\n");
+}
+
+void bench_worker(void)
+{
+	unsigned int cmd, w, i;
+
+	while (1) {
+		cmd = notify_take(1, NOTIFY_FOREVER);
+		w = self() - bench_id - 1;
+		switch (cmd) {
+		case BENCH_CMD_MUTEX:
+			mutex_lock(&bench_mutex);
+			mutex_unlock(&bench_mutex);
+			break;
+		case BENCH_CMD_STRESS:
+			stress(2);
+			break;
+		case BENCH_CMD_PRODUCE:
+			for (i = 1; i <= worker_items[w]; i++)
+				mpmc_push_blocking(&bench_queue, i);
+			break;
+		case BENCH_CMD_CONSUME:
+			for (i = 0; i < worker_items[w]; i++)
+				atomic_fetch_add(&mpmc_sum, mpmc_pop_blocking(&bench_queue));
+			break;
+		}
+		notify_give(bench_id);
+	}
+}
+
+void bench_task(void)
+{
+	unsigned int i;
+
+	bench_id = self();
+	print_str("bench: clock ");
+	print_str(clock_profiles[clock_profile()].name);
+	print_str("\n");
+	bench_yield();
+	bench_notify();
+	bench_sem();
+	bench_mutex_uncontended();
+	bench_mutex_contended();
+	bench_atomic_stress();
+	bench_heap();
+	bench_pool_alloc();
+	bench_usart();
+	bench_workqueue();
+	bench_swtimer();
+	for (i = 0; i < sizeof(mpmc_configs) / sizeof(mpmc_configs[0]); i++)
+		bench_mpmc(mpmc_configs[i].producers, mpmc_configs[i].consumers, mpmc_configs[i].name);
+}
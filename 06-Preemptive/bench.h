@@ -0,0 +1,39 @@
+#ifndef __BENCH_H_
+#define __BENCH_H_
+
+/* Iterations per measured primitive */
+#define BENCH_ROUNDS	1000
+
+/* Iterations per task of the atomics stress test, long enough to be
+ * preempted by several ticks */
+#define STRESS_ROUNDS	200000
+
+/* Worker tasks created right after bench_task */
+#define BENCH_WORKERS	4
+
+/* Words moved per MPMC round and queue capacity */
+#define MPMC_BENCH_ITEMS	1200
+#define MPMC_BENCH_SIZE		16
+
+/* Blocks kept live during the heap benchmark to fragment the pool */
+#define HEAP_BENCH_SLOTS	32
+
+/* Blocks and block size of the pool benchmark */
+#define POOL_BENCH_BLOCKS	8
+#define POOL_BENCH_SIZE		32
+
+/* Expiries of the periodic timer benchmark, one per tick */
+#define SWTIMER_BENCH_EXPIRIES	10
+
+/* Work bench_task hands to a worker through its notification word */
+#define BENCH_CMD_MUTEX		1
+#define BENCH_CMD_STRESS	2
+#define BENCH_CMD_PRODUCE	3
+#define BENCH_CMD_CONSUME	4
+
+unsigned int bench_cycles(void);
+void bench_report(const char *name, unsigned int cycles, unsigned int rounds);
+void bench_task(void);
+void bench_worker(void);
+
+#endif
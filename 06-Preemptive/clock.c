@@ -0,0 +1,119 @@
+#include <stdint.h>
+#include "reg.h"
+#include "asm.h"
+#include "os.h"
+#include "clock.h"
+#include "usart.h"
+
+#define HSE_HZ			8000000
+
+const struct clock_profile clock_profiles[CLOCK_PROFILES] = {
+	[CLOCK_HSE_8] = { "HSE 8 MHz", 8000000, 8000000, 0, 0, 0 },
+	[CLOCK_PLL_36] = { "PLL 36 MHz", 36000000, 36000000, 9, 1, 1 },
+	[CLOCK_PLL_72] = { "PLL 72 MHz", 72000000, 36000000, 9, 0, 2 },
+};
+
+static CLOCK_PROFILE current = CLOCK_HSE_8;
+static unsigned int tick_reload = HSE_HZ / TICK_HZ - 1;
+
+static void flash_set_latency(unsigned int latency)
+{
+	*FLASH_ACR = (*FLASH_ACR & ~FLASH_ACR_LATENCY) | latency;
+}
+
+int clock_set_profile(CLOCK_PROFILE profile)
+{
+	const struct clock_profile *p = &clock_profiles[profile];
+	const struct clock_profile *old = &clock_profiles[current];
+	uint32_t cfgr;
+
+	if (!(*RCC_CR & RCC_CR_HSERDY))
+		return -1;
+
+	/* let the last character leave at the old rate */
+	usart_flush();
+
+	/* park on the HSE while the PLL is reconfigured */
+	*RCC_CFGR = (*RCC_CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSE;
+	while ((*RCC_CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_HSE);
+	*RCC_CR &= ~RCC_CR_PLLON;
+	while (*RCC_CR & RCC_CR_PLLRDY);
+
+	/* more wait states before speeding up, fewer only after slowing down */
+	if (p->latency > old->latency)
+		flash_set_latency(p->latency);
+
+	cfgr = *RCC_CFGR & ~(RCC_CFGR_PPRE1 | RCC_CFGR_PLLSRC_HSE | RCC_CFGR_PLLXTPRE | RCC_CFGR_PLLMULL);
+	if (p->pclk1 != p->hclk)
+		cfgr |= RCC_CFGR_PPRE1_DIV2;
+	if (p->pllmul)
+		cfgr |= RCC_CFGR_PLLSRC_HSE | ((p->pllmul - 2) << RCC_CFGR_PLLMULL_SHIFT);
+	if (p->hse_div2)
+		cfgr |= RCC_CFGR_PLLXTPRE;
+	*RCC_CFGR = cfgr;
+
+	if (p->pllmul) {
+		*RCC_CR |= RCC_CR_PLLON;
+		while (!(*RCC_CR & RCC_CR_PLLRDY));
+		*RCC_CFGR = (*RCC_CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+		while ((*RCC_CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
+	}
+
+	if (p->latency < old->latency)
+		flash_set_latency(p->latency);
+
+	current = profile;
+	tick_reload = p->hclk / TICK_HZ - 1;
+	*SYSTICK_LOAD = tick_reload;
+	*SYSTICK_VAL = 0;
+	usart_clock_changed();
+	return 0;
+}
+
+CLOCK_PROFILE clock_profile(void)
+{
+	return current;
+}
+
+unsigned int clock_hclk(void)
+{
+	return clock_profiles[current].hclk;
+}
+
+unsigned int clock_pclk1(void)
+{
+	return clock_profiles[current].pclk1;
+}
+
+unsigned int clock_tick_reload(void)
+{
+	return tick_reload;
+}
+
+unsigned int clock_cycles(void)
+{
+	unsigned int ticks, val, pending;
+
+	do {
+		ticks = os_ticks;
+		val = *SYSTICK_VAL;
+		pending = *SCB_ICSR & SCB_ICSR_PENDSTSET;
+	} while (ticks != os_ticks);
+	/* the counter wrapped but the handler is held off, by a fast IRQ or
+	 * the tick priority itself: count the tick it has yet to count */
+	if (pending && val > tick_reload / 2)
+		ticks++;
+	return ticks * (tick_reload + 1) + (tick_reload - val);
+}
+
+unsigned int clock_now(void)
+{
+	unsigned int ipsr, control;
+
+	__asm__ __volatile__("mrs %0, ipsr\n\t"
+	                     "mrs %1, control"
+	                     : "=r" (ipsr), "=r" (control));
+	if (ipsr || !(control & 1))
+		return clock_cycles();
+	return cycles_call();
+}
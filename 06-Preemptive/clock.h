@@ -0,0 +1,54 @@
+#ifndef __CLOCK_H_
+#define __CLOCK_H_
+
+/*
+ * System clock profiles. rcc_clock_init() boots on the 8 MHz HSE, main then
+ * moves to the profile picked with `make CLOCK_PROFILE=HSE_8|PLL_36|PLL_72`.
+ * Every switch reprograms the flash wait states, the APB1 prescaler, the
+ * SysTick reload (the tick stays 1 / TICK_HZ s long) and has the USART2
+ * driver recompute its baud divisor. Switching touches SysTick, so it is
+ * for the kernel only.
+ */
+
+#define TICK_HZ		10
+
+typedef enum CLOCK_PROFILE {
+	CLOCK_HSE_8,
+	CLOCK_PLL_36,
+	CLOCK_PLL_72,
+	CLOCK_PROFILES
+} CLOCK_PROFILE;
+
+struct clock_profile {
+	const char *name;
+	unsigned int hclk;		/* Hz, SYSCLK = HCLK */
+	unsigned int pclk1;		/* Hz, at most 36 MHz */
+	unsigned int pllmul;		/* x HSE, 0 runs straight from the HSE */
+	unsigned int hse_div2;		/* feed the PLL with HSE / 2 */
+	unsigned int latency;		/* flash wait states */
+};
+
+extern const struct clock_profile clock_profiles[CLOCK_PROFILES];
+
+#ifndef CLOCK_BOOT
+#define CLOCK_BOOT	CLOCK_PLL_72
+#endif
+
+/* Returns -1 when the HSE is not running */
+int clock_set_profile(CLOCK_PROFILE profile);
+CLOCK_PROFILE clock_profile(void);
+unsigned int clock_hclk(void);
+unsigned int clock_pclk1(void);
+
+/* SysTick reload of the current profile, a tick is that + 1 cycles */
+unsigned int clock_tick_reload(void);
+
+/* Core cycles since the scheduler started. Only differences taken under
+ * the same profile are meaningful. SysTick lives in the System Control
+ * Space, which unprivileged code may not touch: clock_cycles() is for the
+ * kernel and ISRs, clock_now() works anywhere and costs tasks a short SVC
+ * that never reaches the scheduler. */
+unsigned int clock_cycles(void);
+unsigned int clock_now(void);
+
+#endif
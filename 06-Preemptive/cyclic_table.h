@@ -0,0 +1,24 @@
+#ifndef __CYCLIC_TABLE_H_
+#define __CYCLIC_TABLE_H_
+
+/*
+ * Static schedule for SCHED_POLICY=CYCLIC, computed offline. One entry per
+ * minor frame of CYCLIC_MINOR_TICKS ticks, naming the user_task index that
+ * owns the frame or CYCLIC_IDLE. The major frame is the whole table.
+ *
+ * Indexes follow the order main() creates tasks in. The demo build has the
+ * logger and task1 to task3 at 0 to 3 and the shell at 4, the BENCH build
+ * bench_task at 0 and its workers at 1 to 4. The work queue and the timer
+ * daemon are 5 and 6 in both. os.c refuses to build unless every task it
+ * creates owns at least one frame.
+ */
+
+#define CYCLIC_MINOR_TICKS	1
+#define CYCLIC_IDLE		0xFF
+
+#define CYCLIC_TABLE(F)	\
+	F(3) F(2) F(3) F(1) \
+	F(3) F(2) F(3) F(0) \
+	F(5) F(4) F(5) F(6)
+
+#endif
@@ -0,0 +1,140 @@
+#include "edf.h"
+#include "task_order.h"
+
+/* Released, unthrottled jobs ordered by absolute deadline */
+static struct task_heap heap;
+
+/* Every admitted task, earliest next release first */
+static xTask *releases;
+
+/* Sum of wcet / deadline over admitted tasks */
+static unsigned int utilisation;
+
+static inline int earlier(xTask *a, xTask *b)
+{
+	return (int) (a->edf.abs_deadline - b->edf.abs_deadline) < 0;
+}
+
+TASK_HEAP_DEFINE(deadline_heap, earlier, edf.heap_index)
+
+static void heap_remove(xTask *task)
+{
+	deadline_heap_remove(&heap, task);
+	task->edf.heap_index = -1;
+}
+
+/*
+ * Admit a task into the EDF class if the density test still holds, that is
+ * the sum of wcet / min(deadline, period) stays at or below one. Deadlines
+ * longer than the period are not supported. The first job is released on
+ * the next scheduler pass. Returns 0 on success, -1 when rejected or called
+ * once the scheduler runs.
+ */
+int edf_admit(xTask *task, unsigned int period, unsigned int deadline, unsigned int wcet)
+{
+	unsigned int density;
+
+	if (os_running)
+		return -1;
+	if (task->sched_class == SCHED_EDF || !wcet || wcet > deadline || deadline > period)
+		return -1;
+	density = (wcet * EDF_U_SCALE + deadline - 1) / deadline;
+	if (utilisation + density > EDF_U_SCALE)
+		return -1;
+	utilisation += density;
+
+	task->sched_class = SCHED_EDF;
+	task->edf.period = period;
+	task->edf.deadline = deadline;
+	task->edf.wcet = wcet;
+	task->edf.next_release = os_ticks;
+	task->edf.active = 0;
+	task->edf.throttled = 0;
+	task->edf.heap_index = -1;
+	task_info(task)->edf_jobs = 0;
+	task_info(task)->deadline_misses = 0;
+	task_info(task)->budget_overruns = 0;
+	TICK_LIST_INSERT(&releases, task, edf.next_release, edf.release_next);
+	sched_mark(task);
+	return 0;
+}
+
+unsigned int edf_utilisation(void)
+{
+	return utilisation;
+}
+
+/* Keep the heap in step with a task state changed behind our back
+ * (suspend, resume, blocking), called for every task the pass finds marked */
+void edf_sync(xTask *task)
+{
+	struct edf_task *edf = &task->edf;
+
+	if (edf->active && !edf->throttled && task->state == READY && !task->suspended) {
+		if (edf->heap_index < 0)
+			deadline_heap_insert(&heap, task);
+	} else if (edf->heap_index >= 0) {
+		heap_remove(task);
+	}
+}
+
+/* Release due jobs. A job still active at its next release missed its
+ * deadline; one that completes late is counted by edf_job_done(). */
+void edf_release(void)
+{
+	xTask *task;
+	struct edf_task *edf;
+
+	while ((task = releases) && (int) (os_ticks - task->edf.next_release) >= 0) {
+		releases = task->edf.release_next;
+		edf = &task->edf;
+		if (edf->active)
+			task_info(task)->deadline_misses++;
+		if (edf->heap_index >= 0)
+			heap_remove(task);
+		edf->abs_deadline = edf->next_release + edf->deadline;
+		edf->next_release += edf->period;
+		edf->budget = edf->wcet;
+		edf->active = 1;
+		edf->throttled = 0;
+		task_info(task)->edf_jobs++;
+		TICK_LIST_INSERT(&releases, task, edf.next_release, edf.release_next);
+		edf_sync(task);
+	}
+}
+
+/* The job with the earliest deadline, NULL lets fixed priority tasks run */
+__ramfunc xTask *edf_pick(void)
+{
+	return heap.size ? heap.slot[0] : NULL;
+}
+
+/* Charge run time to the current job, throttling it once the budget is gone */
+void edf_charge(xTask *task, unsigned int elapsed)
+{
+	struct edf_task *edf = &task->edf;
+
+	if (task->sched_class != SCHED_EDF || !edf->active)
+		return;
+	if (elapsed < edf->budget) {
+		edf->budget -= elapsed;
+		return;
+	}
+	edf->budget = 0;
+	edf->throttled = 1;
+	task_info(task)->budget_overruns++;
+	if (edf->heap_index >= 0)
+		heap_remove(task);
+}
+
+/* The current job is finished, sleep until the next release */
+void edf_job_done(xTask *task)
+{
+	if (task->sched_class != SCHED_EDF)
+		return;
+	if (task->edf.active && (int) (os_ticks - task->edf.abs_deadline) > 0)
+		task_info(task)->deadline_misses++;
+	task->edf.active = 0;
+	if (task->edf.heap_index >= 0)
+		heap_remove(task);
+}
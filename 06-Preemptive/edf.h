@@ -0,0 +1,31 @@
+#ifndef __EDF_H_
+#define __EDF_H_
+
+#include "os.h"
+
+/*
+ * Earliest-deadline-first scheduling class for periodic tasks.
+ *
+ * A task admitted with edf_admit() releases a job every `period` ticks that
+ * must finish within `deadline` ticks and may consume at most `wcet` ticks.
+ * Released jobs sit in a binary min-heap ordered by absolute deadline and
+ * always run before fixed priority tasks, which get whatever time is left.
+ * A job ends with task_wait_next_period(); a job that exhausts its budget first
+ * is throttled until its next release.
+ */
+
+/* Utilisation is accounted in parts per EDF_U_SCALE */
+#define EDF_U_SCALE	1000
+
+/* From main() only, see os_running */
+int edf_admit(xTask *task, unsigned int period, unsigned int deadline, unsigned int wcet);
+unsigned int edf_utilisation(void);
+
+/* Kernel side, called from Task_scheduler */
+void edf_release(void);
+void edf_sync(xTask *task);
+xTask *edf_pick(void);
+void edf_charge(xTask *task, unsigned int elapsed);
+void edf_job_done(xTask *task);
+
+#endif
@@ -0,0 +1,69 @@
+#include "os.h"
+#include "clock.h"
+#include "governor.h"
+
+static unsigned int enabled;
+static unsigned int window_start;
+static unsigned int idle_cycles;
+static unsigned int last_load;
+static unsigned int switches;
+
+static void window_reset(void)
+{
+	window_start = clock_cycles();
+	idle_cycles = 0;
+}
+
+void governor_start(void)
+{
+	enabled = 1;
+	window_reset();
+}
+
+void governor_idle(unsigned int cycles)
+{
+	idle_cycles += cycles;
+}
+
+void governor_charge(xTask *task, unsigned int cycles)
+{
+	task_info(task)->run_cycles += cycles;
+}
+
+void governor_update(void)
+{
+	unsigned int window = clock_cycles() - window_start;
+	CLOCK_PROFILE profile = clock_profile();
+	unsigned int idle;
+	size_t i;
+
+	if (window < GOVERNOR_WINDOW * (clock_tick_reload() + 1))
+		return;
+	idle = idle_cycles / (window / 1000);
+	last_load = idle < 1000 ? 1000 - idle : 0;
+	for (i = 0; i < nr_tasks; i++) {
+		user_task_info[i].cpu_load = user_task_info[i].run_cycles / (window / 1000);
+		user_task_info[i].run_cycles = 0;
+	}
+
+	if (enabled) {
+		if (last_load > GOVERNOR_UP && profile + 1 < CLOCK_PROFILES)
+			profile++;
+		else if (last_load < GOVERNOR_DOWN && profile > 0)
+			profile--;
+		if (profile != clock_profile() && !clock_set_profile(profile))
+			switches++;
+	}
+	/* cycle counts only compare within one profile, so always start over */
+	window_reset();
+}
+
+unsigned int governor_load(void)
+{
+	return last_load;
+}
+
+unsigned int governor_switches(void)
+{
+	return switches;
+}
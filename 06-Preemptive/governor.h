@@ -0,0 +1,33 @@
+#ifndef __GOVERNOR_H_
+#define __GOVERNOR_H_
+
+#include "os.h"
+
+/*
+ * Load-driven clock governor. The kernel reports the cycles of passes that
+ * found nothing to run, idle task included; every GOVERNOR_WINDOW ticks that
+ * idle time becomes a load figure. Above GOVERNOR_UP the clock steps up one
+ * profile, below GOVERNOR_DOWN it steps down one. Load is measured even
+ * when the governor is not started, for statistics, and so is each task's
+ * share of the window (cpu_load in xTaskInfo).
+ */
+
+/* Ticks per measurement window */
+#define GOVERNOR_WINDOW	10
+
+/* Load thresholds in per mille */
+#define GOVERNOR_UP	800
+#define GOVERNOR_DOWN	300
+
+void governor_start(void);
+
+/* Kernel side, called from Task_scheduler */
+void governor_idle(unsigned int cycles);
+void governor_charge(xTask *task, unsigned int cycles);
+void governor_update(void);
+
+/* Busy per mille of the last complete window */
+unsigned int governor_load(void);
+unsigned int governor_switches(void);
+
+#endif
@@ -0,0 +1,39 @@
+#include "heap.h"
+#include "mutex.h"
+
+extern char _sheap;
+extern char _eheap;
+
+static tlsf_t heap;
+static mutex_t heap_lock;
+
+/* Called once from main before the scheduler starts */
+void heap_init(void)
+{
+	mutex_init(&heap_lock);
+	tlsf_init(&heap, &_sheap, &_eheap - &_sheap);
+}
+
+void *heap_malloc(size_t size)
+{
+	void *ptr;
+
+	mutex_lock(&heap_lock);
+	ptr = tlsf_malloc(&heap, size);
+	mutex_unlock(&heap_lock);
+	return ptr;
+}
+
+void heap_free(void *ptr)
+{
+	mutex_lock(&heap_lock);
+	tlsf_free(&heap, ptr);
+	mutex_unlock(&heap_lock);
+}
+
+void heap_get_stats(tlsf_stats_t *stats)
+{
+	mutex_lock(&heap_lock);
+	tlsf_get_stats(&heap, stats);
+	mutex_unlock(&heap_lock);
+}
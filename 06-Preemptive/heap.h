@@ -0,0 +1,18 @@
+#ifndef __HEAP_H_
+#define __HEAP_H_
+
+#include "tlsf.h"
+
+/*
+ * The task heap: a TLSF pool over the RAM left between the end of .bss and
+ * the main stack (_sheap.._eheap in os.ld). heap_malloc() and heap_free()
+ * serialise on a mutex, so they may be called from any task but not from
+ * handler mode. Both run in bounded time apart from waiting for the lock.
+ */
+
+void heap_init(void);
+void *heap_malloc(size_t size);
+void heap_free(void *ptr);
+void heap_get_stats(tlsf_stats_t *stats);
+
+#endif
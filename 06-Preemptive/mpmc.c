@@ -0,0 +1,107 @@
+#include "atomic.h"
+#include "mpmc.h"
+
+void mpmc_init(mpmc_t *q, struct mpmc_cell *cells, unsigned int size)
+{
+	unsigned int i;
+
+	for (i = 0; i < size; i++)
+		cells[i].seq = i;
+	q->cells = cells;
+	q->mask = size - 1;
+	q->enqueue_pos = 0;
+	q->dequeue_pos = 0;
+	q->consumers_parked = 0;
+	q->producers_parked = 0;
+	sem_init(&q->not_empty, 0);
+	sem_init(&q->not_full, 0);
+}
+
+/*
+ * A cell is free for the producer at position pos when seq == pos, and
+ * holds data for the consumer at pos when seq == pos + 1. Consuming it
+ * makes it free for the producer one lap later, seq = pos + size.
+ */
+int mpmc_push(mpmc_t *q, unsigned int data)
+{
+	struct mpmc_cell *cell;
+	unsigned int pos = q->enqueue_pos;
+	int diff;
+
+	while (1) {
+		cell = &q->cells[pos & q->mask];
+		diff = (int) (atomic_load_acquire(&cell->seq) - pos);
+		if (diff == 0) {
+			if (atomic_cas(&q->enqueue_pos, pos, pos + 1) == pos)
+				break;
+			pos = q->enqueue_pos;
+		} else if (diff < 0) {
+			return 0;
+		} else {
+			pos = q->enqueue_pos;
+		}
+	}
+	cell->data = data;
+	atomic_store_release(&cell->seq, pos + 1);
+	return 1;
+}
+
+int mpmc_pop(mpmc_t *q, unsigned int *data)
+{
+	struct mpmc_cell *cell;
+	unsigned int pos = q->dequeue_pos;
+	int diff;
+
+	while (1) {
+		cell = &q->cells[pos & q->mask];
+		diff = (int) (atomic_load_acquire(&cell->seq) - (pos + 1));
+		if (diff == 0) {
+			if (atomic_cas(&q->dequeue_pos, pos, pos + 1) == pos)
+				break;
+			pos = q->dequeue_pos;
+		} else if (diff < 0) {
+			return 0;
+		} else {
+			pos = q->dequeue_pos;
+		}
+	}
+	*data = cell->data;
+	atomic_store_release(&cell->seq, pos + q->mask + 1);
+	return 1;
+}
+
+/* Announce ourselves as parked, then look once more before sleeping, so a
+ * wake-up sent between the failed attempt and sem_take() is not lost. A
+ * surplus wake-up only costs one more trip round the loop. */
+void mpmc_push_blocking(mpmc_t *q, unsigned int data)
+{
+	while (!mpmc_push(q, data)) {
+		atomic_fetch_add(&q->producers_parked, 1);
+		if (mpmc_push(q, data)) {
+			atomic_fetch_sub(&q->producers_parked, 1);
+			break;
+		}
+		sem_take(&q->not_full, SEM_FOREVER);
+		atomic_fetch_sub(&q->producers_parked, 1);
+	}
+	if (atomic_load_acquire(&q->consumers_parked))
+		sem_give(&q->not_empty);
+}
+
+unsigned int mpmc_pop_blocking(mpmc_t *q)
+{
+	unsigned int data;
+
+	while (!mpmc_pop(q, &data)) {
+		atomic_fetch_add(&q->consumers_parked, 1);
+		if (mpmc_pop(q, &data)) {
+			atomic_fetch_sub(&q->consumers_parked, 1);
+			break;
+		}
+		sem_take(&q->not_empty, SEM_FOREVER);
+		atomic_fetch_sub(&q->consumers_parked, 1);
+	}
+	if (atomic_load_acquire(&q->producers_parked))
+		sem_give(&q->not_full);
+	return data;
+}
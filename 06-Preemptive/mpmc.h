@@ -0,0 +1,46 @@
+#ifndef __MPMC_H_
+#define __MPMC_H_
+
+#include "sem.h"
+
+/*
+ * Bounded multi-producer multi-consumer queue of words, after Dmitry
+ * Vyukov's sequence-numbered ring. Producers and consumers each claim a
+ * slot with one compare-and-swap on their position counter and never wait
+ * for one another, so a task preempted halfway only delays the one slot it
+ * claimed. Capacity must be a power of two; storage is supplied by the
+ * caller.
+ *
+ * The _blocking wrappers park a task on a semaphore when the queue is empty
+ * or full. The semaphore is only touched when somebody is actually parked,
+ * so the busy path stays trap-free.
+ */
+
+struct mpmc_cell {
+	volatile unsigned int seq;
+	unsigned int data;
+};
+
+typedef struct mpmc {
+	struct mpmc_cell *cells;
+	unsigned int mask;
+	volatile unsigned int enqueue_pos;
+	volatile unsigned int dequeue_pos;
+
+	/* blocking wrapper */
+	volatile unsigned int consumers_parked;
+	volatile unsigned int producers_parked;
+	semaphore_t not_empty;
+	semaphore_t not_full;
+} mpmc_t;
+
+void mpmc_init(mpmc_t *q, struct mpmc_cell *cells, unsigned int size);
+
+/* Return 0 when the queue is full / empty */
+int mpmc_push(mpmc_t *q, unsigned int data);
+int mpmc_pop(mpmc_t *q, unsigned int *data);
+
+void mpmc_push_blocking(mpmc_t *q, unsigned int data);
+unsigned int mpmc_pop_blocking(mpmc_t *q);
+
+#endif
@@ -0,0 +1,68 @@
+#include "asm.h"
+#include "mutex.h"
+#include "atomic.h"
+
+void mutex_init(mutex_t *mutex)
+{
+	mutex->word = 0;
+	mutex->waiters = NULL;
+	mutex->contended = 0;
+}
+
+int mutex_trylock(mutex_t *mutex)
+{
+	if (atomic_cas(&mutex->word, 0, 1) != 0)
+		return 0;
+	atomic_acquire();
+	return 1;
+}
+
+void mutex_lock(mutex_t *mutex)
+{
+	if (atomic_cas(&mutex->word, 0, 1) != 0)
+		mutex_call(MUTEX_LOCK, mutex);
+	atomic_acquire();
+}
+
+void mutex_unlock(mutex_t *mutex)
+{
+	atomic_release();
+	if (atomic_cas(&mutex->word, 1, 0) != 1)
+		mutex_call(MUTEX_UNLOCK, mutex);
+}
+
+/*
+ * Slow paths. The kernel is never interrupted by a task, so plain accesses
+ * to the word are atomic here. A woken waiter returns from its trap already
+ * owning the lock.
+ */
+void mutex_syscall(xTask *task, unsigned int op, mutex_t *mutex)
+{
+	xTask **link;
+	xTask *waiter;
+
+	if (op == MUTEX_LOCK) {
+		mutex->contended++;
+		if (mutex->word == 0) {
+			mutex->word = 1;
+			return;
+		}
+		mutex->word = 2;
+		link = &mutex->waiters;
+		while (*link && (*link)->priority >= task->priority)
+			link = &(*link)->mutex_next;
+		task->mutex_next = *link;
+		*link = task;
+		task->state = WAITING;
+		return;
+	}
+
+	waiter = mutex->waiters;
+	if (!waiter) {
+		mutex->word = 0;
+		return;
+	}
+	mutex->waiters = waiter->mutex_next;
+	mutex->word = mutex->waiters ? 2 : 1;
+	task_wake(waiter);
+}
@@ -0,0 +1,34 @@
+#ifndef __MUTEX_H_
+#define __MUTEX_H_
+
+#include "os.h"
+
+/*
+ * Mutex with a user-space fast path, futex style. The lock word is
+ * 0 (free), 1 (locked) or 2 (locked, maybe with waiters). Taking a free
+ * lock and releasing one nobody waits for is a single LDREX/STREX sequence
+ * without any trap. Only when the word says otherwise does the caller trap
+ * into the kernel, which blocks it in priority order or hands the lock
+ * straight to the first waiter.
+ */
+
+typedef struct mutex {
+	volatile unsigned int word;
+	xTask *waiters;
+	unsigned int contended;		/* slow path lock attempts */
+} mutex_t;
+
+typedef enum MUTEX_OP {
+	MUTEX_LOCK,
+	MUTEX_UNLOCK
+} MUTEX_OP;
+
+void mutex_init(mutex_t *mutex);
+void mutex_lock(mutex_t *mutex);
+int mutex_trylock(mutex_t *mutex);
+void mutex_unlock(mutex_t *mutex);
+
+/* Kernel side */
+void mutex_syscall(xTask *task, unsigned int op, mutex_t *mutex);
+
+#endif
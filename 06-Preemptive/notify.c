@@ -0,0 +1,120 @@
+#include "asm.h"
+#include "notify.h"
+#include "task_order.h"
+
+/* Timed waiters, earliest expiry first */
+static xTask *timeouts;
+
+/* Consume the value according to the take mode and return what was there */
+static unsigned int take_value(xTask *task)
+{
+	unsigned int value = task->notify_value;
+
+	if (task->notify_clear)
+		task->notify_value = 0;
+	else
+		task->notify_value--;
+	return value;
+}
+
+/* Update the word of `dst` and wake it if it is blocked in notify_take(),
+ * returns whether it did */
+static int notify_post(xTask *dst, unsigned int op, unsigned int value)
+{
+	switch (op) {
+	case NOTIFY_GIVE:
+		dst->notify_value++;
+		break;
+	case NOTIFY_SET_BITS:
+		dst->notify_value |= value;
+		break;
+	case NOTIFY_OVERWRITE:
+		dst->notify_value = value;
+		break;
+	default:
+		return 0;
+	}
+
+	if (!dst->notify_waiting || !dst->notify_value)
+		return 0;
+	if (dst->notify_timeout != NOTIFY_FOREVER)
+		TICK_LIST_REMOVE(&timeouts, dst, notify_timeout_next);
+	dst->notify_waiting = 0;
+	dst->task_address[FRAME_R0] = take_value(dst);
+	task_wake(dst);
+	return 1;
+}
+
+/* Handle a notify_call() trap from `task` */
+unsigned int notify_syscall(xTask *task, unsigned int op, unsigned int arg0, unsigned int arg1)
+{
+	if (op != NOTIFY_TAKE) {
+		if (arg0 < nr_tasks)
+			notify_post(&user_task[arg0], op, arg1);
+		return 0;
+	}
+
+	task->notify_clear = arg0;
+	if (task->notify_value)
+		return take_value(task);
+	if (!arg1)
+		return 0;
+	task->notify_waiting = 1;
+	task->notify_timeout = arg1;
+	task->notify_wake = os_ticks + arg1;
+	if (arg1 != NOTIFY_FOREVER)
+		TICK_LIST_INSERT(&timeouts, task, notify_wake, notify_timeout_next);
+	task->state = WAITING;
+	return 0;
+}
+
+/* Time out waits that have expired, called once per scheduler pass */
+void notify_poll(void)
+{
+	xTask *task;
+
+	while ((task = timeouts) && (int) (os_ticks - task->notify_wake) >= 0) {
+		timeouts = task->notify_timeout_next;
+		task->notify_waiting = 0;
+		task->task_address[FRAME_R0] = 0;
+		task_wake(task);
+	}
+}
+
+void notify_give(unsigned int task)
+{
+	notify_call(NOTIFY_GIVE, task, 0);
+}
+
+void notify_set_bits(unsigned int task, unsigned int bits)
+{
+	notify_call(NOTIFY_SET_BITS, task, bits);
+}
+
+void notify_overwrite(unsigned int task, unsigned int value)
+{
+	notify_call(NOTIFY_OVERWRITE, task, value);
+}
+
+unsigned int notify_take(unsigned int clear, unsigned int timeout)
+{
+	return notify_call(NOTIFY_TAKE, clear, timeout);
+}
+
+void notify_give_from_isr(unsigned int task)
+{
+	if (task < nr_tasks && notify_post(&user_task[task], NOTIFY_GIVE, 0))
+		sched_preempt_from_isr();
+}
+
+void notify_set_bits_from_isr(unsigned int task, unsigned int bits)
+{
+	if (task < nr_tasks && notify_post(&user_task[task], NOTIFY_SET_BITS, bits))
+		sched_preempt_from_isr();
+}
+
+void notify_overwrite_from_isr(unsigned int task, unsigned int value)
+{
+	if (task < nr_tasks && notify_post(&user_task[task], NOTIFY_OVERWRITE, value))
+		sched_preempt_from_isr();
+}
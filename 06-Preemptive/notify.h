@@ -0,0 +1,43 @@
+#ifndef __NOTIFY_H_
+#define __NOTIFY_H_
+
+#include "os.h"
+
+/*
+ * Direct-to-task notifications: every task owns one 32-bit notification
+ * word that other tasks and ISRs update without any queue or semaphore
+ * object. A task blocked in notify_take() is made READY right away by the
+ * update and resumes with the value it was waiting for.
+ *
+ * From tasks use the plain calls, which trap into the kernel. From ISRs use
+ * the _from_isr variants; such ISRs must run at IRQ_PRIO_KERNEL (nvic.h),
+ * the kernel's own exception priority, so they never interleave with it.
+ */
+
+#define NOTIFY_FOREVER	0xFFFFFFFF
+
+typedef enum NOTIFY_OP {
+	NOTIFY_GIVE,		/* increment, a lightweight counting semaphore */
+	NOTIFY_SET_BITS,	/* OR in event bits */
+	NOTIFY_OVERWRITE,	/* replace the value, a single-slot mailbox */
+	NOTIFY_TAKE		/* kernel use: wait for a non-zero value */
+} NOTIFY_OP;
+
+void notify_give(unsigned int task);
+void notify_set_bits(unsigned int task, unsigned int bits);
+void notify_overwrite(unsigned int task, unsigned int value);
+
+/* Wait up to `timeout` ticks for a non-zero value and return it, 0 on
+ * timeout. The word is then cleared, or only decremented when `clear` is 0. */
+unsigned int notify_take(unsigned int clear, unsigned int timeout);
+
+/* For ISRs at IRQ_PRIO_KERNEL: a task woken here runs once the ISR returns */
+void notify_give_from_isr(unsigned int task);
+void notify_set_bits_from_isr(unsigned int task, unsigned int bits);
+void notify_overwrite_from_isr(unsigned int task, unsigned int value);
+
+/* Kernel side */
+unsigned int notify_syscall(xTask *task, unsigned int op, unsigned int arg0, unsigned int arg1);
+void notify_poll(void);
+
+#endif
@@ -0,0 +1,59 @@
+#include <stdint.h>
+#include "reg.h"
+#include "nvic.h"
+
+void nvic_enable_irq(unsigned int irq)
+{
+	*NVIC_ISER(irq / 32) = 1U << (irq % 32);
+}
+
+void nvic_disable_irq(unsigned int irq)
+{
+	*NVIC_ICER(irq / 32) = 1U << (irq % 32);
+}
+
+void nvic_set_pending(unsigned int irq)
+{
+	*NVIC_ISPR(irq / 32) = 1U << (irq % 32);
+}
+
+void nvic_clear_pending(unsigned int irq)
+{
+	*NVIC_ICPR(irq / 32) = 1U << (irq % 32);
+}
+
+int nvic_is_pending(unsigned int irq)
+{
+	return !!(*NVIC_ISPR(irq / 32) & (1U << (irq % 32)));
+}
+
+int nvic_is_active(unsigned int irq)
+{
+	return !!(*NVIC_IABR(irq / 32) & (1U << (irq % 32)));
+}
+
+void nvic_set_priority(unsigned int irq, unsigned int level)
+{
+	*NVIC_IPR(irq) = IRQ_PRIO_BYTE(level);
+}
+
+unsigned int nvic_get_priority(unsigned int irq)
+{
+	return *NVIC_IPR(irq) >> (8 - NVIC_PRIO_BITS);
+}
+
+void scb_set_priority(unsigned int exc, unsigned int level)
+{
+	*SCB_SHPR(exc) = IRQ_PRIO_BYTE(level);
+}
+
+void nvic_init(void)
+{
+	unsigned int irq;
+
+	for (irq = 0; irq < IRQ_COUNT; irq++)
+		nvic_set_priority(irq, IRQ_PRIO_KERNEL);
+	scb_set_priority(SVCALL_EXCn, IRQ_PRIO_KERNEL);
+	scb_set_priority(PENDSV_EXCn, IRQ_PRIO_KERNEL);
+	scb_set_priority(SYSTICK_EXCn, IRQ_PRIO_TICK);
+}
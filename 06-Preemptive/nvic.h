@@ -0,0 +1,55 @@
+#ifndef __NVIC_H_
+#define __NVIC_H_
+
+/*
+ * NVIC and system exception priorities. The STM32F103 implements the top
+ * NVIC_PRIO_BITS of each priority byte; the API takes levels 0 (most
+ * urgent) to 15.
+ *
+ * Everything that touches kernel state runs at IRQ_PRIO_KERNEL: SVC, PendSV
+ * and every ISR using a _from_isr call. None of them can preempt another,
+ * so they never interleave with the kernel, which itself is only entered
+ * through SVC and PendSV. SysTick sits one level above and preempts a task
+ * by pending PendSV, so ticks keep counting while the kernel runs. Levels more
+ * urgent than IRQ_PRIO_TICK are for fast peripherals: they preempt the
+ * kernel and are never masked by it, and in exchange may not call into it.
+ */
+
+#define NVIC_PRIO_BITS	4
+#define NVIC_PRIO_LEVELS	(1 << NVIC_PRIO_BITS)
+
+#define IRQ_PRIO_FAST	0
+#define IRQ_PRIO_TICK	(NVIC_PRIO_LEVELS / 2 - 1)
+#define IRQ_PRIO_KERNEL	(NVIC_PRIO_LEVELS / 2)
+
+/* Priority level as stored in the priority byte and BASEPRI */
+#define IRQ_PRIO_BYTE(level)	((level) << (8 - NVIC_PRIO_BITS))
+
+void nvic_enable_irq(unsigned int irq);
+void nvic_disable_irq(unsigned int irq);
+void nvic_set_pending(unsigned int irq);
+void nvic_clear_pending(unsigned int irq);
+int nvic_is_pending(unsigned int irq);
+int nvic_is_active(unsigned int irq);
+void nvic_set_priority(unsigned int irq, unsigned int level);
+unsigned int nvic_get_priority(unsigned int irq);
+
+/* System exceptions, exc is one of the *_EXCn numbers in reg.h */
+void scb_set_priority(unsigned int exc, unsigned int level);
+
+/* Apply the priority layout above, called once from main */
+void nvic_init(void);
+
+/*
+ * Mask every interrupt at IRQ_PRIO_KERNEL and below, leaving SysTick and
+ * fast IRQs running; never lowers a mask already in place. There is no
+ * exit: activate() clears BASEPRI when it dispatches a task.
+ * BASEPRI is a privileged register: for the kernel and main only.
+ */
+static inline void critical_enter(void)
+{
+	__asm__ __volatile__("msr basepri_max, %0"
+	                     :: "r" (IRQ_PRIO_BYTE(IRQ_PRIO_KERNEL)) : "memory");
+}
+
+#endif
@@ -3,21 +3,27 @@
 #include <string.h>
 #include "reg.h"
 #include "asm.h"
+#include "os.h"
+#include "uring.h"
+#include "edf.h"
+#include "periodic.h"
+#include "reserve.h"
+#include "notify.h"
+#include "sem.h"
+#include "mutex.h"
+#include "heap.h"
+#include "pool.h"
+#include "clock.h"
+#include "usart.h"
+#include "nvic.h"
+#include "governor.h"
+#include "shell.h"
+#include "workqueue.h"
+#include "swtimer.h"
+#include "bench.h"
+#include "sched.h"
 #include "semihost/host.h"
 
-
-/* Size of our user task stacks in words */
-#define STACK_SIZE	256
-
-/* Number of user task */
-#define TASK_LIMIT	5
-
-/* USART TXE Flag
- * This flag is cleared when data is written to USARTx_DR and
- * set when that data is transferred to the TDR
- */
-#define USART_FLAG_TXE	((uint16_t) 0x0080)
-
 /* reverse:  reverse string s in place */
 void reverse(char s[])
 {
@@ -53,69 +59,44 @@ void itoa(int n, char s[])
 
 
 
-void usart_init(void)
-{
-	*(RCC_APB2ENR) |= (uint32_t)(0x00000001 | 0x00000004);
-	*(RCC_APB1ENR) |= (uint32_t)(0x00020000);
-
-	/* USART2 Configuration, Rx->PA3, Tx->PA2 */
-	*(GPIOA_CRL) = 0x00004B00;
-	*(GPIOA_CRH) = 0x44444444;
-	*(GPIOA_ODR) = 0x00000000;
-	*(GPIOA_BSRR) = 0x00000000;
-	*(GPIOA_BRR) = 0x00000000;
-
-	*(USART2_CR1) = 0x0000000C;
-	*(USART2_CR2) = 0x00000000;
-	*(USART2_CR3) = 0x00000000;
-	*(USART2_CR1) |= 0x2000;
-}
-
-typedef enum TASK_STATE {
-	WAITING,
-	RUNNING,
-	READY,
-	SUSPENDED,
-	CREATED
-} TASK_STATE;
-
-/*
- * The Task_scheduler is a state used for checking the second level priority queue
- */
-typedef enum TASK_SCHEDULING_STATE {
-	SCHEDULED,
-	UNSCHEDULED
-} TASK_SCHEDULING_STATE;
-
-typedef struct Task {
-	const char* task_name;
-	unsigned int priority;/* the number bigger,then the priority is higher.This is the current priority*/
-	unsigned int *task_address;
-	unsigned int user_stack[STACK_SIZE];
-	TASK_STATE state;
-	TASK_SCHEDULING_STATE sch_state;
-} xTask;
-
 xTask user_task[TASK_LIMIT];
-static unsigned int scheduler_initial_flag = 1;
+xTaskInfo user_task_info[TASK_LIMIT];
+unsigned int user_stack[TASK_LIMIT][STACK_SIZE] __attribute__((section(".stacks")));
+
+/* Words of stack for the idle task: its initial frame plus one exception frame */
+#define IDLE_STACK_SIZE	64
+
+static unsigned int idle_stack[IDLE_STACK_SIZE] __attribute__((section(".stacks")));
+static unsigned int *idle_address;
+size_t nr_tasks;
+unsigned int os_running;
+volatile unsigned int os_ticks;
+unsigned int sched_dirty;
+struct sched_stats sched_stats;
+volatile unsigned int trap_source;
+volatile unsigned int pendsv_tick;	/* the pending PendSV comes from SysTick */
 
 void print_str(const char *str)
 {
-	while (*str) {
-		while (!(*(USART2_SR) & USART_FLAG_TXE));
-		*(USART2_DR) = (*str & 0xFF);
-		str++;
-	}
+	usart_write(str);
 }
 
 
 void print_int(int n)
 {
-	char buf[] = "\0";
+	char buf[12];	/* sign, 10 digits and the NUL */
 	itoa(n, buf);
 	print_str(buf);
 }
 
+/* Trace of every scheduler pass. It costs milliseconds of polled UART per
+ * pass, which benchmarks would measure instead of the kernel. */
+#ifdef BENCH
+#define trace_str(str)
+#else
+#define trace_str(str)	print_str(str)
+#endif
+
 
 void delay(int count)
 {
@@ -128,35 +109,40 @@ void delay(int count)
 #define THREAD_MSP	0xFFFFFFF9
 #define THREAD_PSP	0xFFFFFFFD
 
-/* Initilize user task stack and execute it one time */
-/* XXX: Implementation of task creation is a little bit tricky. In fact,
- * after the second time we called `activate()` which is returning from
- * exception. But the first time we called `activate()` which is not returning
- * from exception. Thus, we have to set different `lr` value.
- * First time, we should set function address to `lr` directly. And after the
- * second time, we should set `THREAD_PSP` to `lr` so that exception return
- * works correctly.
+/* Initilize user task stack with the frame an exception return expects, so
+ * the task first runs when the scheduler picks it. The software part holds
+ * r4-r11 and the EXC_RETURN value `activate()` branches to, the hardware part
+ * holds r0-r3, r12, lr, pc and xPSR. A task returning from its entry function
+ * lands in `task_exit()`.
+ * The very first dispatch happens from thread mode where EXC_RETURN has no
+ * meaning, `activate()` unstacks that frame by hand instead.
  * http://infocenter.arm.com/help/index.jsp?topic=/com.arm.doc.dui0552a/Babefdjc.html
  */
+static unsigned int *build_frame(unsigned int *stack, size_t words, void (*start)(void))
+{
+	stack += words - 32; /* End of stack, minus what we are about to push */
+	memset(stack, 0, (FRAME_PSR + 1) * sizeof(unsigned int));
+	stack[FRAME_SW_WORDS - 1] = (unsigned int) THREAD_PSP;
+	stack[FRAME_LR] = (unsigned int) task_exit;
+	stack[FRAME_PC] = (unsigned int) start & ~1U; /* Thumb state lives in xPSR */
+	stack[FRAME_PSR] = (unsigned int) 0x01000000; /* PSR Thumb bit */
+	return stack;
+}
+
 unsigned int *create_task(unsigned int *stack, void (*start)(void), unsigned int priority, const char* name, size_t task_count)
 {
-	static int first = 1;
-
-	stack += STACK_SIZE - 32; /* End of stack, minus what we are about to push */
-	if (first) {
-		stack[8] = (unsigned int) start;
-		first = 0;
-	} else {
-		stack[8] = (unsigned int) THREAD_PSP;
-		stack[15] = (unsigned int) start;
-		stack[16] = (unsigned int) 0x01000000; /* PSR Thumb bit */
-	}
-	user_task[task_count].state = CREATED;
+	size_t i;
+
+	for (i = 0; i < STACK_SIZE; i++)
+		stack[i] = STACK_FILL;
+	user_task_info[task_count].stack = stack;
+	stack = build_frame(stack, STACK_SIZE, start);
+
+	user_task_info[task_count].task_name = name;
 	user_task[task_count].priority = priority;
-	user_task[task_count].task_name = name;
-	stack = activate(stack);
 	user_task[task_count].state = READY;
 	user_task[task_count].sch_state = UNSCHEDULED;
+	sched_mark(&user_task[task_count]);
 	return stack;
 }
 
@@ -171,87 +157,240 @@ unsigned int *create_task(unsigned int *stack, void (*start)(void), unsigned int
  */
 void Task_suspend(xTask *task)
 {
-	task->state = SUSPENDED;
 	print_str("\n");
-	print_str(task->task_name);
+	print_str(task_info(task)->task_name);
 	print_str(" is suspended!\n");
-	*SYSTICK_VAL = 0;
-	syscall();
+	task_call(TASK_SUSPEND, task, 0);
 }
 
 void Task_resume(xTask *task)
 {
-	task->state = READY;
 	print_str("\n");
-	print_str(task->task_name);
-	print_str(" resume to READY state!\n");
-	*SYSTICK_VAL = 0;
-	syscall();
+	print_str(task_info(task)->task_name);
+	print_str(" is resumed!\n");
+	task_call(TASK_RESUME, task, 0);
 }
 
 void Task_modify_priority(xTask *task, unsigned int pri)
 {
-	task->priority = pri;
-	scheduler_initial_flag = 1;
+	task_call(TASK_SET_PRIORITY, task, pri);
 	print_str("\nModify priority for ");
-	print_str(task->task_name);
+	print_str(task_info(task)->task_name);
 	print_str(" : ");
 	print_int(task->priority);
 	print_str("\n");
 }
 
+void Task_set_tickets(xTask *task, unsigned int tickets)
+{
+	task_call(TASK_SET_TICKETS, task, tickets);
+	print_str("\nSet tickets for ");
+	print_str(task_info(task)->task_name);
+	print_str(" : ");
+	print_int(task->tickets);
+	print_str("\n");
+}
+
+unsigned int Task_stack_high_water(xTask *task)
+{
+	unsigned int *stack = task_info(task)->stack;
+	size_t unused = 0;
+
+	while (unused < STACK_SIZE && stack[unused] == STACK_FILL)
+		unused++;
+	return (STACK_SIZE - unused) * sizeof(unsigned int);
+}
+
+/* Handle a task_call() trap: task states and the policy's ready set may
+ * only be touched here, where no tick can cut into them */
+static void task_syscall(unsigned int op, xTask *task, unsigned int value)
+{
+	if (task < user_task || task >= user_task + nr_tasks)
+		return;
+
+	switch (op) {
+	case TASK_SUSPEND:
+		task->suspended = 1;
+		sched_mark(task);
+		break;
+	case TASK_RESUME:
+		/* a task suspended while blocked keeps waiting */
+		if (task->suspended && task->state == READY)
+			task->ready_since = os_ticks;
+		task->suspended = 0;
+		sched_mark(task);
+		break;
+	case TASK_SET_PRIORITY:
+		task->priority = value;
+		sched_reprioritise(task);
+		break;
+	case TASK_SET_TICKETS:
+		task->tickets = value;
+		sched_reprioritise(task);
+		break;
+	}
+}
+
+/* Decode the svc immediate of a trapped task and carry out its request */
+static void svc_dispatch(xTask *task)
+{
+	unsigned int *frame = task->task_address;
+	uint16_t svc_insn = ((uint16_t *) frame[FRAME_PC])[-1];
+
+	switch (svc_insn & 0xFF) {
+	case SVC_EXIT:
+		task->state = TERMINATED;
+		print_str(task_info(task)->task_name);
+		print_str(" exited\n");
+		break;
+	case SVC_WAIT_PERIOD:
+		if (task->sched_class == SCHED_EDF)
+			edf_job_done(task);
+		else
+			periodic_wait(task);
+		break;
+	case SVC_NOTIFY:
+		frame[FRAME_R0] = notify_syscall(task, frame[FRAME_R0], frame[FRAME_R1], frame[FRAME_R2]);
+		break;
+	case SVC_SEM:
+		frame[FRAME_R0] = sem_syscall(task, frame[FRAME_R0], (semaphore_t *) frame[FRAME_R1], frame[FRAME_R2]);
+		break;
+	case SVC_MUTEX:
+		mutex_syscall(task, frame[FRAME_R0], (mutex_t *) frame[FRAME_R1]);
+		break;
+	case SVC_TASK:
+		task_syscall(frame[FRAME_R0], (xTask *) frame[FRAME_R1], frame[FRAME_R2]);
+		break;
+	case SVC_URING_ENTER:
+		frame[FRAME_R0] = uring_submit(task, (struct uring *) frame[FRAME_R0], frame[FRAME_R1]);
+		break;
+	case SVC_YIELD:
+	default:
+		break;
+	}
+}
+
+void sched_preempt_from_isr(void)
+{
+	*SCB_ICSR = SCB_ICSR_PENDSVSET;
+}
+
+/*
+ * Run when no task may. The kernel itself cannot wait: it runs at
+ * IRQ_PRIO_KERNEL, or under BASEPRI before the first trap, and would hold
+ * off the very interrupts that make a task runnable. Here every level is
+ * open, and a tick or an ISR waking a task pends PendSV back to the kernel.
+ */
+static void idle_task(void)
+{
+	while (1)
+		__asm__ __volatile__("wfi");
+}
 
 void Task_scheduler(xTask tasks[], size_t created_task_number)
 {
 	*SYSTICK_VAL = 0;
-	size_t current_task = 0;
-	unsigned int max = 0;
-	unsigned int i = 0;
-	unsigned int j = 0;
-	scheduler_initial_flag = 1;
-	xTask *pTask[created_task_number];
-
+	unsigned int tick_start;
+	unsigned int pass_start;
+	unsigned int pass;
+	unsigned int run_start;
+	unsigned int elapsed;
+	unsigned int cycles;
+	unsigned int wait;
+	unsigned int trap;
+	xTask *next;
+
+	nr_tasks = created_task_number;
+	os_running = 1;
+	idle_address = build_frame(idle_stack, IDLE_STACK_SIZE, idle_task);
+	/* until the first trap the kernel runs in thread mode, keep kernel-level
+	 * ISRs out as the exception priority does later; activate() unmasks */
+	critical_enter();
 	while (1) {
-		current_task = 0;
-		max = 0;
-		i = 0;//level 1:priority based
-		if ((j == created_task_number) || (scheduler_initial_flag == 1)) { //level 2: round robin
-			j = 0;
-			for (; j < created_task_number; j++) {
-				tasks[j].sch_state = UNSCHEDULED;
-			}
-			scheduler_initial_flag = 0;
-			j = 0;
+		/* after a profile switch, so the pass is timed on one scale */
+		governor_update();
+		pass_start = clock_cycles();
+		uring_poll();
+		notify_poll();
+		sem_poll();
+		edf_release();
+		periodic_release();
+		reserve_replenish();
+		sched_sync();
+
+		next = edf_pick();//released EDF jobs run before any fixed priority task
+		if (!next)
+			next = sched_pick_next();
+		if (!next) {
+			idle_address = activate(idle_address);
+			trap_source = 0;
+			governor_idle(clock_cycles() - pass_start);
+			continue;
 		}
 
-		for (; i < created_task_number; i++) { //level 1
-			if (tasks[i].priority > max && (tasks[i].state == READY) && (tasks[i].sch_state == UNSCHEDULED)) {
-				max = tasks[i].priority;
-				current_task = i;
-			}
+		pass = clock_cycles() - pass_start;
+		sched_stats.passes++;
+		sched_stats.pass_cycles_last = pass;
+		if (pass > sched_stats.pass_cycles_max)
+			sched_stats.pass_cycles_max = pass;
+
+		trace_str("OS: Activate next task\n");
+		trap = 0;
+		elapsed = 0;
+		cycles = 0;
+		if (next->state == READY) {
+			wait = os_ticks - next->ready_since;
+			if (wait > task_info(next)->max_wait_ticks)
+				task_info(next)->max_wait_ticks = wait;
+			periodic_dispatch(next);
+			next->state = RUNNING;
+			tick_start = os_ticks;
+			run_start = clock_cycles();
+			next->task_address = activate(next->task_address);//activate
+			trap = trap_source;
+			trap_source = 0;
+			elapsed = os_ticks - tick_start;
+			cycles = clock_cycles() - run_start;
+			governor_charge(next, cycles);
+			edf_charge(next, elapsed);
+			reserve_charge(next, tick_start, elapsed);
 		}
-		pTask[j] = &tasks[current_task];//level 2
-		pTask[j]->sch_state = SCHEDULED;
-
-		print_str("OS: Activate next task\n");
-		if (pTask[j]->state == READY) {
-			pTask[j]->state = RUNNING;
-			pTask[j]->task_address = activate(pTask[j]->task_address);//activate
+		if (next->state == RUNNING) { //if  the state is changed during the process modify its running time
+			next->state = READY;
+			next->ready_since = os_ticks;
 		}
-		if (pTask[j]->state == RUNNING) { //if  the state is changed during the process modify its running time
-			pTask[j]->state = READY;
+		if (trap == TRAP_SVC)
+			svc_dispatch(next);
+		if (next->sched_class == SCHED_FIXED) {
+			if (trap == TRAP_TICK)
+				sched_tick(next, elapsed, cycles);
+			else if (trap == TRAP_SVC)
+				sched_yield(next, cycles);
 		}
+		/* it blocked, exited or goes back to the ready set */
+		sched_mark(next);
 
-		j++;
-		print_str("OS: Back to OS\n");
+		trace_str("OS: Back to OS\n");
 
 	}
 }
 
+/*
+ * Demo workload, one task per kind of scheduling, times in ticks: the
+ * logger is an EDF job, task 1 a reserved fixed priority task, task 2
+ * sleeps through a uring and task 3 is rate monotonic.
+ */
+#define DEMO_LOGGER_PERIOD	20
+#define DEMO_LOGGER_WCET	5
+#define DEMO_TASK1_CAPACITY	5
+#define DEMO_TASK1_PERIOD	10
+#define DEMO_SLEEP_TICKS	10
+#define DEMO_TASK3_PERIOD	10
+
 void semihost_logger(void)
 {
 	int handle , error;
-	/*char output[512] = {0};*/
+	char *output = heap_malloc(512);
 	char *buf;
 	print_str("semihost_logger Created!\n");
 	handle = host_action(SYS_SYSTEM, "mkdir -p output");
@@ -262,18 +401,22 @@ void semihost_logger(void)
 	if (handle == -1) {
 		print_str("Open file error!\n");
 	}
-	syscall();
+	if (!output) {
+		print_str("Out of memory!\n");
+		return;
+	}
 	while (1) {
 		buf = "Test for semihost!\n";
-		/*memcpy(output, (char *)buf, strlen((char*)buf));*/
+		memcpy(output, (char *)buf, strlen((char*)buf));
 		print_str("semihost_logger is logging!\n");
-		error = host_action(SYS_WRITE, handle, (void*)buf, strlen((char *)buf));
+		error = host_action(SYS_WRITE, handle, (void*)output, strlen((char *)buf));
 		if (error != 0) {
 			print_str("Write file error!\n");
 			host_action(SYS_CLOSE, handle);
+			heap_free(output);
 			return;
 		}
-		syscall();
+		task_wait_next_period();
 	}
 	host_action(SYS_CLOSE, handle);
 }
@@ -281,18 +424,18 @@ void semihost_logger(void)
 void task1_func(void)
 {
 	print_str("task1: Created!\n");
-	syscall();
 	int test = 0;
 	xTask *ptr = &user_task[2];
 	while (1) {
 		print_str("Running...");
-		print_str(user_task[1].task_name);
+		print_str(user_task_info[1].task_name);
 		print_str("\n");
 		delay(1000);
 
 		test++;
 		if (test == 10) {
 			Task_modify_priority(ptr, 20);
+			Task_set_tickets(ptr, 20);
 			print_str("task 2 gets highest priority!");
 		}
 		if (test == 15) {
@@ -302,15 +445,21 @@ void task1_func(void)
 }
 
 
+/* Sleeps through its submission ring rather than spinning in delay() */
 void task2_func(void)
 {
+	struct uring ring;
+	struct uring_cqe cqe;
+
 	print_str("task2: Created!\n");
-	syscall();
+	uring_init(&ring);
 	while (1) {
 		print_str("Running...");
-		print_str(user_task[2].task_name);
+		print_str(user_task_info[2].task_name);
 		print_str("\n");
-		delay(1000);
+		uring_prep(&ring, URING_OP_SLEEP, 0, DEMO_SLEEP_TICKS, 0);
+		uring_enter(&ring, 1);
+		uring_peek_cqe(&ring, &cqe);
 	}
 }
 
@@ -318,44 +467,98 @@ void task2_func(void)
 void task3_func(void)
 {
 	print_str("task3: Created!\n");
-	syscall();
 	while (1) {
 		print_str("Running...");
-		print_str(user_task[3].task_name);
+		print_str(user_task_info[3].task_name);
 		print_str("\n");
-		delay(1000);
+		task_wait_next_period();
 	}
 }
 
 
 
+/* Tasks main() creates, in this order: the demo or bench tasks, then the
+ * work queue and the timer daemon */
+#ifdef BENCH
+#define MAIN_TASKS	(1 + BENCH_WORKERS + 2)
+#else
+#define MAIN_TASKS	(5 + 2)
+#endif
+
+#if MAIN_TASKS > TASK_LIMIT
+#error "main() creates more tasks than TASK_LIMIT"
+#endif
+#if SCHED_POLICY == SCHED_POLICY_CYCLIC && CYCLIC_TASK_MASK != (1U << MAIN_TASKS) - 1
+#error "cyclic_table.h must give every task main() creates a frame"
+#endif
+
 int main(void)
 {
 	size_t task_count = 0;
+#ifdef BENCH
+	int i;
+#endif
 
-	usart_init();
+	nvic_init();
+	usart_init(USART_BAUD);
+	clock_set_profile(CLOCK_BOOT);
+	heap_init();
+	pool_init_all();
 
 	print_str("OS: Starting...\n");
-	print_str("OS: First create semihost_logger !\n");
-	user_task[task_count].task_address = create_task(user_task[task_count].user_stack, &semihost_logger, 0, "semihost_logger!", task_count);
+#ifdef BENCH
+	/* benchmarks run alone, the demo tasks would only add noise */
+	print_str("OS: Create bench tasks\n");
+	user_task[task_count].task_address = create_task(user_stack[task_count], &bench_task, 15, "bench", task_count);
 	task_count += 1;
-	print_str("OS: Back to OS, create task 1\n");
-	user_task[task_count].task_address = create_task(user_task[task_count].user_stack, &task1_func, 1, "task_name_1", task_count);
+	for (i = 0; i < BENCH_WORKERS; i++) {
+		user_task[task_count].task_address = create_task(user_stack[task_count], &bench_worker, 15, "bench_worker", task_count);
+		task_count += 1;
+	}
+#else
+	print_str("OS: Create semihost_logger\n");
+	user_task[task_count].task_address = create_task(user_stack[task_count], &semihost_logger, 0, "semihost_logger!", task_count);
+	if (edf_admit(&user_task[task_count], DEMO_LOGGER_PERIOD, DEMO_LOGGER_PERIOD, DEMO_LOGGER_WCET))
+		print_str("OS: semihost_logger not admitted\n");
+	task_count += 1;
+	print_str("OS: Create task 1\n");
+	user_task[task_count].task_address = create_task(user_stack[task_count], &task1_func, 1, "task_name_1", task_count);
+	reserve_attach(&user_task[task_count], DEMO_TASK1_CAPACITY, DEMO_TASK1_PERIOD);
+	task_count += 1;
+
+	print_str("OS: Create task 2\n");
+	user_task[task_count].task_address = create_task(user_stack[task_count], &task2_func, 10, "task_name_2", task_count);
+	task_count += 1;
+
+	print_str("OS: Create task 3\n");
+	user_task[task_count].task_address = task_create_periodic(user_stack[task_count], &task3_func, "task_name_3", task_count, DEMO_TASK3_PERIOD, 0);
+	task_count += 1;
+
+	print_str("OS: Create shell\n");
+	user_task[task_count].task_address = create_task(user_stack[task_count], &shell_task, 13, "shell", task_count);
+	usart_rx_attach(task_count);
 	task_count += 1;
+#endif
 
-	print_str("OS: Back to OS, create task 2\n");
-	user_task[task_count].task_address = create_task(user_task[task_count].user_stack, &task2_func, 10, "task_name_2", task_count);
+	/* kernel services, after the tasks above so their indexes stay put */
+	print_str("OS: Create workqueue\n");
+	user_task[task_count].task_address = create_task(user_stack[task_count], &workqueue_task, 15, "workqueue", task_count);
+	workqueue_attach(task_count);
 	task_count += 1;
 
-	print_str("OS: Back to OS, create task 3\n");
-	user_task[task_count].task_address = create_task(user_task[task_count].user_stack, &task3_func, 14, "task_name_3", task_count);
+	print_str("OS: Create timer daemon\n");
+	user_task[task_count].task_address = create_task(user_stack[task_count], &swtimer_daemon, 14, "swtimer", task_count);
+	swtimer_attach(task_count);
 	task_count += 1;
 
 	/* SysTick configuration */
-	*SYSTICK_LOAD = 7200000;
+#ifdef GOVERNOR
+	governor_start();
+#endif
+	*SYSTICK_LOAD = clock_tick_reload();
 	*SYSTICK_VAL = 0;
 	*SYSTICK_CTRL = 0x07;
 	print_str("Scheduler start!\n");
-	Task_scheduler(user_task, task_count); /*priority based with round-robin 2 level scheduler*/
+	Task_scheduler(user_task, task_count); /*policy picked at build time, see sched.h*/
 	return 0;
 }
@@ -0,0 +1,260 @@
+#ifndef __OS_H_
+#define __OS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Run a function from SRAM: it is linked into .ramfunc and copied there by
+ * reset_handler, so it pays no flash wait states. Calls between flash and
+ * SRAM are out of BL range, the linker routes them through veneers. */
+#define __ramfunc	__attribute__((section(".ramfunc")))
+
+/* Size of our user task stacks in words */
+#define STACK_SIZE	256
+
+/* Pattern unused stack words keep, for the high-water mark */
+#define STACK_FILL	0xDEADBEEF
+
+/* Number of user task, at most 32 so a task set fits in one word */
+#define TASK_LIMIT	8
+
+/* Depth of each task's message mailbox, power of two */
+#define MAILBOX_SIZE	4
+
+/* Layout of a switched-out task stack: r4-r11 and EXC_RETURN are pushed by
+ * the trap handler, right below the frame the hardware stacked on entry.
+ * Indexes are in words from the saved stack pointer.
+ */
+#define FRAME_SW_WORDS	9
+#define FRAME_R0	(FRAME_SW_WORDS + 0)
+#define FRAME_R1	(FRAME_SW_WORDS + 1)
+#define FRAME_R2	(FRAME_SW_WORDS + 2)
+#define FRAME_R3	(FRAME_SW_WORDS + 3)
+#define FRAME_R12	(FRAME_SW_WORDS + 4)
+#define FRAME_LR	(FRAME_SW_WORDS + 5)
+#define FRAME_PC	(FRAME_SW_WORDS + 6)
+#define FRAME_PSR	(FRAME_SW_WORDS + 7)
+
+typedef enum TASK_STATE {
+	WAITING,
+	RUNNING,
+	READY,
+	SUSPENDED,	/* only shown by ps, see xTask.suspended */
+	CREATED,
+	TERMINATED
+} TASK_STATE;
+
+/*
+ * The Task_scheduler is a state used for checking the second level priority queue
+ */
+typedef enum TASK_SCHEDULING_STATE {
+	SCHEDULED,
+	UNSCHEDULED
+} TASK_SCHEDULING_STATE;
+
+/* Scheduling classes, EDF jobs always run before fixed priority tasks */
+#define SCHED_FIXED	0
+#define SCHED_EDF	1
+
+/* EDF parameters and job state, all times in ticks, see edf.h */
+struct edf_task {
+	unsigned int period;
+	unsigned int deadline;		/* relative to the release */
+	unsigned int wcet;		/* budget granted to each job */
+	unsigned int next_release;
+	unsigned int abs_deadline;	/* of the current job */
+	unsigned int budget;		/* left to the current job */
+	unsigned int active;		/* released and not completed yet */
+	unsigned int throttled;		/* overran its budget, parked until the next release */
+	int heap_index;			/* -1 when not in the ready heap */
+	struct Task *release_next;	/* in the release list, by next_release */
+};
+
+/* Rate monotonic periodic task state, in ticks, see periodic.h */
+struct periodic_task {
+	unsigned int period;		/* 0 for aperiodic tasks */
+	unsigned int next_release;
+	unsigned int release;		/* of the current job */
+	unsigned int started;		/* current job has been dispatched */
+	unsigned int waiting;		/* blocked in task_wait_next_period() */
+	struct Task *release_next;	/* in the release list while waiting */
+};
+
+/* CPU reservation enforced as a sporadic server, in ticks, see reserve.h */
+#define RESERVE_REPL_MAX	4
+
+struct reserve {
+	unsigned int capacity;		/* budget per period, 0 when not reserved */
+	unsigned int period;
+	unsigned int budget;		/* left right now */
+	unsigned int throttled;		/* out of budget, waiting for a replenishment */
+	unsigned int repl_count;	/* pending replenishments, oldest first */
+	unsigned int repl_tick[RESERVE_REPL_MAX];
+	unsigned int repl_amount[RESERVE_REPL_MAX];
+	struct Task *repl_next;		/* in the replenishment list while repl_count */
+};
+
+/* Changes to another task's state or scheduling parameters, made by the
+ * kernel on behalf of Task_suspend() and friends */
+typedef enum TASK_OP {
+	TASK_SUSPEND,
+	TASK_RESUME,
+	TASK_SET_PRIORITY,
+	TASK_SET_TICKETS
+} TASK_OP;
+
+struct uring;
+struct semaphore;
+
+/*
+ * The scheduling record, what the scheduler pass and the syscalls touch. It
+ * holds no stack, name or statistics and the fields every pass reads come
+ * first; the rest lives in xTaskInfo.
+ */
+typedef struct Task {
+	TASK_STATE state;
+	unsigned int priority;/* the number bigger,then the priority is higher.This is the current priority*/
+	TASK_SCHEDULING_STATE sch_state;
+	unsigned int sched_class;
+	unsigned int suspended;		/* by Task_suspend(), on top of state */
+	unsigned int sch_queued;	/* in the policy's ready set, see sched.h */
+	unsigned int ready_since;	/* tick it last became READY, drives aging */
+	unsigned int *task_address;	/* saved stack pointer */
+	struct Task *sch_next;		/* ready queue link */
+	unsigned int mlfq_level;
+	unsigned int mlfq_used;		/* core cycles of the level's quantum consumed */
+	unsigned int tickets;		/* stride share, 0 means priority + 1 */
+	unsigned int stride_pass;
+	unsigned int stride_last;	/* stride the pass was last advanced with */
+	unsigned int stride_index;	/* position in the stride heap */
+	unsigned int stride_run;	/* ticks run in the current share window */
+
+	/* direct-to-task notification, see notify.h */
+	unsigned int notify_value;
+	unsigned int notify_waiting;	/* blocked in notify_take() */
+	unsigned int notify_clear;	/* take mode of that wait */
+	unsigned int notify_timeout;
+	unsigned int notify_wake;	/* tick the wait times out at */
+	struct Task *notify_timeout_next;	/* in the timed wait list */
+
+	/* counting semaphore wait, see sem.h */
+	struct semaphore *sem_waiting;
+	struct Task *sem_next;		/* in the semaphore's wait queue */
+	struct Task *sem_timeout_next;	/* in the timed wait list */
+	unsigned int sem_timeout;
+	unsigned int sem_wake;
+	struct Task *mutex_next;	/* in a mutex wait queue, see mutex.h */
+	struct edf_task edf;
+	struct periodic_task rm;
+	struct reserve rsv;
+
+	/* syscall batching, see uring.h */
+	struct uring *ring;		/* registered on the first uring_enter() */
+	unsigned int wait_nr;		/* completions a WAITING task still needs */
+	unsigned int sleep_tick;	/* wake-up tick of an outstanding SLEEP */
+	struct Task *sleep_next;	/* in the sleep list, by sleep_tick */
+	unsigned int sleep_user_data;
+	unsigned int sleep_pending;
+	unsigned int recv_user_data;
+	unsigned int recv_pending;
+	unsigned int mailbox[MAILBOX_SIZE];
+	unsigned int mailbox_head;
+	unsigned int mailbox_tail;
+} xTask;
+
+/* Per-task data off the scheduling path, indexed like user_task */
+typedef struct TaskInfo {
+	const char *task_name;
+	unsigned int *stack;		/* lowest word of the task's stack */
+	unsigned int max_wait_ticks;	/* longest READY-to-dispatch wait seen */
+	unsigned int frame_overruns;	/* cyclic executive frames overrun */
+	unsigned int stride_share;	/* per mille of the last window actually received */
+	unsigned int run_cycles;	/* run time in the current load window, see governor.h */
+	unsigned int cpu_load;		/* per mille of the last load window */
+
+	/* EDF jobs, see edf.h */
+	unsigned int edf_jobs;
+	unsigned int deadline_misses;
+	unsigned int budget_overruns;
+
+	/* rate monotonic jobs, in ticks, see periodic.h */
+	unsigned int rm_jobs;
+	unsigned int rm_overruns;	/* job still running at its next release */
+	unsigned int jitter_max;	/* release to first dispatch */
+	unsigned int response_last;	/* release to completion */
+	unsigned int response_max;
+
+	unsigned int throttle_count;	/* reservation ran dry, see reserve.h */
+} xTaskInfo;
+
+extern xTask user_task[TASK_LIMIT];
+extern xTaskInfo user_task_info[TASK_LIMIT];
+extern size_t nr_tasks;
+
+/* Task stacks, in their own .stacks section */
+extern unsigned int user_stack[TASK_LIMIT][STACK_SIZE];
+
+static inline xTaskInfo *task_info(xTask *task)
+{
+	return &user_task_info[task - user_task];
+}
+
+/*
+ * Set once Task_scheduler() takes over. Task setup calls such as
+ * task_create_periodic(), edf_admit() and reserve_attach() change kernel
+ * structures without a trap, so they are for main() only and fail after.
+ */
+extern unsigned int os_running;
+
+/* Incremented by the SysTick handler, also while the kernel is running */
+extern volatile unsigned int os_ticks;
+
+/*
+ * Tasks whose runnability may have changed since the last scheduler pass,
+ * one bit per user_task index. Whatever wakes a task, throttles it or lets
+ * it go again marks it, and the pass looks at those tasks only.
+ */
+extern unsigned int sched_dirty;
+
+/* Scheduler pass cost, from the top of the loop to the task switch */
+struct sched_stats {
+	unsigned int passes;
+	unsigned int pass_cycles_last;
+	unsigned int pass_cycles_max;
+};
+
+extern struct sched_stats sched_stats;
+
+static inline void sched_mark(xTask *task)
+{
+	sched_dirty |= 1U << (task - user_task);
+}
+
+/* End a wait: a WAITING task becomes READY, and runs once nothing else,
+ * such as a suspension, holds it back */
+static inline void task_wake(xTask *task)
+{
+	if (task->state == WAITING) {
+		task->state = READY;
+		task->ready_since = os_ticks;
+	}
+	sched_mark(task);
+}
+
+/* Have the kernel run a pass as soon as the current ISR returns, for an ISR
+ * that just made a task runnable */
+void sched_preempt_from_isr(void);
+
+void print_str(const char *str);
+void print_int(int n);
+
+unsigned int *create_task(unsigned int *stack, void (*start)(void), unsigned int priority, const char* name, size_t task_count);
+void Task_suspend(xTask *task);
+void Task_resume(xTask *task);
+void Task_modify_priority(xTask *task, unsigned int pri);
+void Task_set_tickets(xTask *task, unsigned int tickets);
+
+/* Deepest stack use seen so far, in bytes */
+unsigned int Task_stack_high_water(xTask *task);
+
+#endif
@@ -0,0 +1,97 @@
+#include "periodic.h"
+#include "task_order.h"
+
+/* Periodic tasks waiting for their next job, earliest release first */
+static xTask *releases;
+
+/* Re-rank every periodic task, the shortest period gets the highest priority */
+static void assign_rm_priorities(void)
+{
+	size_t i, j;
+	unsigned int slower;
+
+	for (i = 0; i < TASK_LIMIT; i++) {
+		if (!user_task[i].rm.period)
+			continue;
+		slower = 0;
+		for (j = 0; j < TASK_LIMIT; j++) {
+			if (user_task[j].rm.period > user_task[i].rm.period)
+				slower++;
+		}
+		user_task[i].priority = RM_PRIORITY_BASE + 1 + slower;
+	}
+}
+
+unsigned int *task_create_periodic(unsigned int *stack, void (*start)(void), const char *name,
+                                   size_t task_count, unsigned int period, unsigned int offset)
+{
+	xTask *task = &user_task[task_count];
+	struct periodic_task *rm = &task->rm;
+
+	if (os_running)
+		return NULL;
+	stack = create_task(stack, start, RM_PRIORITY_BASE, name, task_count);
+	rm->period = period;
+	rm->next_release = os_ticks + offset;
+	rm->waiting = 1;
+	TICK_LIST_INSERT(&releases, task, rm.next_release, rm.release_next);
+	task->state = WAITING;
+	assign_rm_priorities();
+	return stack;
+}
+
+/* Release the jobs of waiting periodic tasks that are due */
+void periodic_release(void)
+{
+	xTask *task;
+	struct periodic_task *rm;
+
+	while ((task = releases) && (int) (os_ticks - task->rm.next_release) >= 0) {
+		releases = task->rm.release_next;
+		rm = &task->rm;
+		rm->release = rm->next_release;
+		rm->next_release += rm->period;
+		rm->started = 0;
+		rm->waiting = 0;
+		task_info(task)->rm_jobs++;
+		task_wake(task);
+	}
+}
+
+/* Measure release jitter on the first dispatch of a job */
+void periodic_dispatch(xTask *task)
+{
+	struct periodic_task *rm = &task->rm;
+	xTaskInfo *info = task_info(task);
+	unsigned int jitter;
+
+	if (!rm->period || rm->started)
+		return;
+	rm->started = 1;
+	jitter = os_ticks - rm->release;
+	if (jitter > info->jitter_max)
+		info->jitter_max = jitter;
+}
+
+/* The current job is complete: record its response time and block until the
+ * next release, or carry on right away when that release already passed */
+void periodic_wait(xTask *task)
+{
+	struct periodic_task *rm = &task->rm;
+	xTaskInfo *info = task_info(task);
+
+	if (!rm->period)
+		return;
+	info->response_last = os_ticks - rm->release;
+	if (info->response_last > info->response_max)
+		info->response_max = info->response_last;
+
+	rm->waiting = 1;
+	TICK_LIST_INSERT(&releases, task, rm.next_release, rm.release_next);
+	if ((int) (os_ticks - rm->next_release) >= 0) {
+		info->rm_overruns++;
+		return;
+	}
+	if (task->state == READY)
+		task->state = WAITING;
+}
@@ -0,0 +1,35 @@
+#ifndef __PERIODIC_H_
+#define __PERIODIC_H_
+
+#include "os.h"
+
+/*
+ * Rate monotonic periodic tasks.
+ *
+ * task_create_periodic() creates a task whose first job is released `offset`
+ * ticks after creation and then every `period` ticks, without the drift of a
+ * delay() loop. Each job ends with task_wait_next_period(). Periodic tasks
+ * are fixed priority tasks ranked by rate: the shorter the period, the higher
+ * the priority, all of them above RM_PRIORITY_BASE. That ranking bounds
+ * release jitter only under SCHED_POLICY=PRIO_RR, which exempts periodic
+ * tasks from its round; RR, STRIDE and CYCLIC ignore priorities and MLFQ
+ * replaces them with its levels.
+ *
+ * Per task the kernel records in xTaskInfo release jitter (release to first
+ * dispatch), response time (release to completion) and overruns (jobs still
+ * running when the next one is due).
+ */
+
+/* Priorities handed out to periodic tasks start right above this */
+#define RM_PRIORITY_BASE	15
+
+/* From main() only, see os_running. Returns NULL once the scheduler runs. */
+unsigned int *task_create_periodic(unsigned int *stack, void (*start)(void), const char *name,
+                                   size_t task_count, unsigned int period, unsigned int offset);
+
+/* Kernel side, called from Task_scheduler */
+void periodic_release(void);
+void periodic_dispatch(xTask *task);
+void periodic_wait(xTask *task);
+
+#endif
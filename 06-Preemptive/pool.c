@@ -0,0 +1,78 @@
+#include "pool.h"
+#include "atomic.h"
+
+/* Bounds of the .pools section, defined in os.ld */
+extern pool_t _spools[];
+extern pool_t _epools[];
+
+static void pool_init(pool_t *pool)
+{
+	char *block = pool->storage;
+	unsigned int i;
+
+	pool->free = NULL;
+	for (i = pool->nr_blocks; i > 0; i--) {
+		*(void **) (block + (i - 1) * pool->block_size) = pool->free;
+		pool->free = block + (i - 1) * pool->block_size;
+	}
+	pool->used = 0;
+	pool->high_water = 0;
+	pool->failures = 0;
+}
+
+void pool_init_all(void)
+{
+	pool_t *pool;
+
+	for (pool = _spools; pool < _epools; pool++)
+		pool_init(pool);
+}
+
+/* Returns NULL when every block is in use */
+void *pool_alloc(pool_t *pool)
+{
+	volatile unsigned int *head = (volatile unsigned int *) &pool->free;
+	void **block;
+	unsigned int used, high;
+
+	do {
+		block = (void **) atomic_ldrex(head);
+		if (!block) {
+			atomic_clrex();
+			atomic_fetch_add(&pool->failures, 1);
+			return NULL;
+		}
+	} while (atomic_strex(head, (unsigned int) *block));
+	atomic_acquire();
+
+	used = atomic_fetch_add(&pool->used, 1) + 1;
+	do {
+		high = pool->high_water;
+	} while (used > high && atomic_cas(&pool->high_water, high, used) != high);
+	return block;
+}
+
+void pool_free(pool_t *pool, void *block)
+{
+	volatile unsigned int *head = (volatile unsigned int *) &pool->free;
+	unsigned int next;
+
+	if (!block)
+		return;
+	atomic_release();
+	do {
+		next = atomic_ldrex(head);
+		*(void **) block = (void *) next;
+	} while (atomic_strex(head, (unsigned int) block));
+	atomic_fetch_sub(&pool->used, 1);
+}
+
+pool_t *pool_first(void)
+{
+	return _spools;
+}
+
+pool_t *pool_end(void)
+{
+	return _epools;
+}
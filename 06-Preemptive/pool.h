@@ -0,0 +1,57 @@
+#ifndef __POOL_H_
+#define __POOL_H_
+
+#include <stddef.h>
+
+/*
+ * Fixed-size block pools. While a block is free its first word links it to
+ * the next free block, so a pool costs nothing beyond its blocks and one
+ * descriptor. Allocation and release pop and push that list with
+ * LDREX/STREX: they are O(1), never trap and may be called from tasks and
+ * interrupt handlers alike. An interrupted pop retries, since exception
+ * entry clears the exclusive monitor, which also rules out ABA on a single
+ * core.
+ *
+ * POOL_DEFINE places the descriptor in the .pools section and the blocks in
+ * .pool_storage (see os.ld), so pool_init_all() finds every pool in the
+ * image without a registry.
+ */
+
+typedef struct pool {
+	const char *name;
+	void *storage;
+	unsigned int block_size;
+	unsigned int nr_blocks;
+	void *volatile free;
+	volatile unsigned int used;
+	volatile unsigned int high_water;	/* most blocks ever in use at once */
+	volatile unsigned int failures;		/* allocations that found the pool empty */
+} pool_t;
+
+/* Blocks hold at least the free list link and stay word aligned */
+#define POOL_BLOCK_SIZE(size) \
+	((size) < sizeof(void *) ? sizeof(void *) : ((size) + 3) & ~3U)
+
+#define POOL_DEFINE(var, size, count)						\
+	static unsigned int var##_storage[(count) * POOL_BLOCK_SIZE(size) / 4]	\
+		__attribute__((section(".pool_storage")));			\
+	pool_t var __attribute__((section(".pools"), used)) = {		\
+		.name = #var,							\
+		.storage = var##_storage,					\
+		.block_size = POOL_BLOCK_SIZE(size),				\
+		.nr_blocks = (count),						\
+	}
+
+#define POOL_DECLARE(var)	extern pool_t var
+
+/* Called once from main before the scheduler starts */
+void pool_init_all(void);
+
+void *pool_alloc(pool_t *pool);
+void pool_free(pool_t *pool, void *block);
+
+/* Every pool in the image, for statistics */
+pool_t *pool_first(void);
+pool_t *pool_end(void);
+
+#endif
@@ -17,10 +17,40 @@
 #define RCC_BDCR	((__REG) (RCC + 0x20))
 #define RCC_CSR		((__REG) (RCC + 0x24))
 
+/* Bit definition for RCC_CR register */
+#define RCC_CR_HSION		((uint32_t) 0x00000001)	/* Internal High Speed clock enable */
+#define RCC_CR_HSEON		((uint32_t) 0x00010000)	/* External High Speed clock enable */
+#define RCC_CR_HSERDY		((uint32_t) 0x00020000)	/* External High Speed clock ready flag */
+#define RCC_CR_CSSON		((uint32_t) 0x00080000)	/* Clock Security System enable */
+#define RCC_CR_PLLON		((uint32_t) 0x01000000)
+#define RCC_CR_PLLRDY		((uint32_t) 0x02000000)
+
+/* Bit definition for RCC_CFGR register */
+#define RCC_CFGR_SW		((uint32_t) 0x00000003)	/* SW[1:0] bits (System clock Switch) */
+#define RCC_CFGR_SW_HSE		((uint32_t) 0x00000001)
+#define RCC_CFGR_SW_PLL		((uint32_t) 0x00000002)
+#define RCC_CFGR_SWS		((uint32_t) 0x0000000C)	/* SWS[1:0] bits (System Clock Switch Status) */
+#define RCC_CFGR_SWS_HSE	((uint32_t) 0x00000004)
+#define RCC_CFGR_SWS_PLL	((uint32_t) 0x00000008)
+#define RCC_CFGR_HPRE_DIV1	((uint32_t) 0x00000000)	/* SYSCLK not divided */
+#define RCC_CFGR_PPRE1		((uint32_t) 0x00000700)
+#define RCC_CFGR_PPRE1_DIV1	((uint32_t) 0x00000000)	/* HCLK not divided */
+#define RCC_CFGR_PPRE1_DIV2	((uint32_t) 0x00000400)
+#define RCC_CFGR_PPRE2_DIV1	((uint32_t) 0x00000000)	/* HCLK not divided */
+#define RCC_CFGR_PLLSRC_HSE	((uint32_t) 0x00010000)
+#define RCC_CFGR_PLLXTPRE	((uint32_t) 0x00020000)
+#define RCC_CFGR_PLLMULL	((uint32_t) 0x003C0000)
+#define RCC_CFGR_PLLMULL_SHIFT	18
+
 /* Flash Memory Map */
 #define FLASH		((__REG_TYPE) 0x40022000)
 #define FLASH_ACR	((__REG) (FLASH + 0x00))
 
+/* Bit definition for FLASH_ACR register */
+#define FLASH_ACR_LATENCY	((uint32_t) 0x00000007)	/* LATENCY[2:0] bits (Latency) */
+#define FLASH_ACR_LATENCY_0	((uint32_t) 0x00000000)	/* zero wait states */
+#define FLASH_ACR_PRFTBE	((uint32_t) 0x00000010)	/* Prefetch Buffer Enable */
+
 /* GPIO Memory Map */
 #define GPIOA		((__REG_TYPE) 0x40010800)
 #define GPIOA_CRL	((__REG) (GPIOA + 0x00))
@@ -48,4 +78,40 @@
 #define SYSTICK_VAL	((__REG) (SYSTICK + 0x08))
 #define SYSTICK_CALIB	((__REG) (SYSTICK + 0x0C))
 
+/* NVIC Memory Map, n selects the word holding IRQs 32n to 32n + 31 */
+#define NVIC		((__REG_TYPE) 0xE000E100)
+#define NVIC_ISER(n)	((__REG) (NVIC + 0x000 + 4 * (n)))
+#define NVIC_ICER(n)	((__REG) (NVIC + 0x080 + 4 * (n)))
+#define NVIC_ISPR(n)	((__REG) (NVIC + 0x100 + 4 * (n)))
+#define NVIC_ICPR(n)	((__REG) (NVIC + 0x180 + 4 * (n)))
+#define NVIC_IABR(n)	((__REG) (NVIC + 0x200 + 4 * (n)))
+#define NVIC_IPR(irq)	((volatile uint8_t *) (NVIC + 0x300 + (irq)))
+
+/* SCB Memory Map */
+#define SCB		((__REG_TYPE) 0xE000ED00)
+#define SCB_CPUID	((__REG) (SCB + 0x00))
+#define SCB_ICSR	((__REG) (SCB + 0x04))
+#define SCB_VTOR	((__REG) (SCB + 0x08))
+#define SCB_AIRCR	((__REG) (SCB + 0x0C))
+#define SCB_SCR		((__REG) (SCB + 0x10))
+#define SCB_CCR		((__REG) (SCB + 0x14))
+#define SCB_SHPR(exc)	((volatile uint8_t *) (SCB + 0x18 + (exc) - 4))
+#define SCB_SHCSR	((__REG) (SCB + 0x24))
+
+/* Bit definition for SCB_ICSR register */
+#define SCB_ICSR_PENDSTSET	((uint32_t) 0x04000000)	/* SysTick pending */
+#define SCB_ICSR_PENDSVSET	((uint32_t) 0x10000000)	/* set PendSV pending */
+
+/* System exception numbers, as used by SCB_SHPR */
+#define MEMMANAGE_EXCn	4
+#define BUSFAULT_EXCn	5
+#define USAGEFAULT_EXCn	6
+#define SVCALL_EXCn	11
+#define PENDSV_EXCn	14
+#define SYSTICK_EXCn	15
+
+/* External interrupt numbers, the vector of IRQ n is at 16 + n */
+#define USART2_IRQn	38
+#define IRQ_COUNT	43
+
 #endif
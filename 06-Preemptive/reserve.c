@@ -0,0 +1,90 @@
+#include "reserve.h"
+#include "task_order.h"
+
+/* Reserved tasks with replenishments pending, earliest first */
+static xTask *pending;
+
+/* Reserve `capacity` ticks every `period` ticks for task, 0 removes the
+ * reservation. Returns -1 for a capacity larger than the period, or once
+ * the scheduler runs. */
+int reserve_attach(xTask *task, unsigned int capacity, unsigned int period)
+{
+	struct reserve *rsv = &task->rsv;
+
+	if (os_running || capacity > period)
+		return -1;
+	if (rsv->repl_count)
+		TICK_LIST_REMOVE(&pending, task, rsv.repl_next);
+	rsv->capacity = capacity;
+	rsv->period = period;
+	rsv->budget = capacity;
+	rsv->throttled = 0;
+	task_info(task)->throttle_count = 0;
+	rsv->repl_count = 0;
+	sched_mark(task);
+	return 0;
+}
+
+/* Charge a run of `elapsed` ticks that began at `start`, the amount comes
+ * back at start + period */
+void reserve_charge(xTask *task, unsigned int start, unsigned int elapsed)
+{
+	struct reserve *rsv = &task->rsv;
+	unsigned int last;
+
+	if (!rsv->capacity || !elapsed)
+		return;
+	if (elapsed > rsv->budget)
+		elapsed = rsv->budget;
+	rsv->budget -= elapsed;
+	if (rsv->repl_count)
+		TICK_LIST_REMOVE(&pending, task, rsv.repl_next);
+
+	/* out of slots: fold into the latest one and move it to this run's
+	 * time, its earlier amount then comes back late but never early */
+	last = rsv->repl_count - 1;
+	if (rsv->repl_count && (rsv->repl_count == RESERVE_REPL_MAX ||
+	                        rsv->repl_tick[last] == start + rsv->period)) {
+		rsv->repl_tick[last] = start + rsv->period;
+		rsv->repl_amount[last] += elapsed;
+	} else {
+		rsv->repl_tick[rsv->repl_count] = start + rsv->period;
+		rsv->repl_amount[rsv->repl_count] = elapsed;
+		rsv->repl_count++;
+	}
+	TICK_LIST_INSERT(&pending, task, rsv.repl_tick[0], rsv.repl_next);
+
+	if (!rsv->budget) {
+		rsv->throttled = 1;
+		task_info(task)->throttle_count++;
+	}
+}
+
+/* Hand back budget whose replenishment time has come */
+void reserve_replenish(void)
+{
+	xTask *task;
+	unsigned int j;
+	struct reserve *rsv;
+
+	while ((task = pending) && (int) (os_ticks - task->rsv.repl_tick[0]) >= 0) {
+		pending = task->rsv.repl_next;
+		rsv = &task->rsv;
+		while (rsv->repl_count && (int) (os_ticks - rsv->repl_tick[0]) >= 0) {
+			rsv->budget += rsv->repl_amount[0];
+			if (rsv->budget > rsv->capacity)
+				rsv->budget = rsv->capacity;
+			rsv->repl_count--;
+			for (j = 0; j < rsv->repl_count; j++) {
+				rsv->repl_tick[j] = rsv->repl_tick[j + 1];
+				rsv->repl_amount[j] = rsv->repl_amount[j + 1];
+			}
+		}
+		if (rsv->repl_count)
+			TICK_LIST_INSERT(&pending, task, rsv.repl_tick[0], rsv.repl_next);
+		if (rsv->budget && rsv->throttled) {
+			rsv->throttled = 0;
+			sched_mark(task);
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#ifndef __RESERVE_H_
+#define __RESERVE_H_
+
+#include "os.h"
+
+/*
+ * CPU reservations for fixed priority tasks, enforced as a sporadic server.
+ *
+ * A reserved task may run `capacity` ticks in any window of `period` ticks.
+ * Every stretch of execution is paid back one period after it started, so
+ * the guarantee holds over any sliding window rather than only on period
+ * boundaries. A task that runs out of budget is throttled, which takes it
+ * out of the ready set until the next replenishment, and the event counted
+ * in the task's xTaskInfo throttle_count.
+ */
+
+/* From main() only, see os_running */
+int reserve_attach(xTask *task, unsigned int capacity, unsigned int period);
+
+/* Kernel side, called from Task_scheduler */
+void reserve_charge(xTask *task, unsigned int start, unsigned int elapsed);
+void reserve_replenish(void);
+
+#endif
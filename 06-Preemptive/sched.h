@@ -0,0 +1,136 @@
+#ifndef __SCHED_H_
+#define __SCHED_H_
+
+#include "os.h"
+#include "edf.h"
+
+/*
+ * Scheduling policy for the fixed priority class, picked at build time with
+ * `make SCHED_POLICY=<PRIO_RR|RR|MLFQ|STRIDE|CYCLIC>`. Each policy is a header of static
+ * inline operations so Task_scheduler calls them without any indirection:
+ *
+ *   sched_enqueue(task)      task became runnable
+ *   sched_dequeue(task)      task left the ready set without being picked
+ *   sched_pick_next()        choose the next task and take it off the ready
+ *                            set, NULL when nothing is runnable
+ *   sched_tick(task, ticks, cycles)
+ *                            task was preempted by SysTick after running
+ *                            `ticks` ticks, or `cycles` core cycles
+ *   sched_yield(task, cycles) task trapped into the kernel on its own after
+ *                            running `cycles` core cycles
+ *   sched_reprioritise(task) task->priority or task->tickets was changed,
+ *                            always from the kernel, see Task_modify_priority()
+ *
+ * A task preempted because an ISR woke another (TRAP_WAKE) gets neither a
+ * tick nor a yield, it only goes back to the ready set.
+ *
+ * Only Task_scheduler (os.c) includes this header.
+ */
+
+#define SCHED_POLICY_PRIO_RR	0	/* priority based with round-robin 2 level scheduler */
+#define SCHED_POLICY_RR		1	/* plain round-robin, priorities ignored */
+#define SCHED_POLICY_MLFQ	2	/* multilevel feedback queue */
+#define SCHED_POLICY_STRIDE	3	/* proportional share by tickets */
+#define SCHED_POLICY_CYCLIC	4	/* time-triggered static table */
+
+#ifndef SCHED_POLICY
+#define SCHED_POLICY	SCHED_POLICY_PRIO_RR
+#endif
+
+/* Intrusive FIFO of tasks linked through sch_next */
+struct task_queue {
+	xTask *head;
+	xTask *tail;
+};
+
+static inline void task_queue_push(struct task_queue *q, xTask *task)
+{
+	task->sch_next = NULL;
+	if (q->tail)
+		q->tail->sch_next = task;
+	else
+		q->head = task;
+	q->tail = task;
+}
+
+static inline void task_queue_push_front(struct task_queue *q, xTask *task)
+{
+	task->sch_next = q->head;
+	q->head = task;
+	if (!q->tail)
+		q->tail = task;
+}
+
+static inline __ramfunc xTask *task_queue_pop(struct task_queue *q)
+{
+	xTask *task = q->head;
+
+	if (task) {
+		q->head = task->sch_next;
+		if (!q->head)
+			q->tail = NULL;
+	}
+	return task;
+}
+
+static inline void task_queue_remove(struct task_queue *q, xTask *task)
+{
+	xTask **link = &q->head;
+	xTask *prev = NULL;
+
+	while (*link && *link != task) {
+		prev = *link;
+		link = &(*link)->sch_next;
+	}
+	if (!*link)
+		return;
+	*link = task->sch_next;
+	if (q->tail == task)
+		q->tail = prev;
+}
+
+/* Whether the policy may pick a task at all */
+static inline __ramfunc int sched_runnable(xTask *task)
+{
+	return task->state == READY && task->sched_class == SCHED_FIXED &&
+	       !task->suspended && !task->rsv.throttled;
+}
+
+#if SCHED_POLICY == SCHED_POLICY_PRIO_RR
+#include "sched_prio_rr.h"
+#elif SCHED_POLICY == SCHED_POLICY_RR
+#include "sched_rr.h"
+#elif SCHED_POLICY == SCHED_POLICY_MLFQ
+#include "sched_mlfq.h"
+#elif SCHED_POLICY == SCHED_POLICY_STRIDE
+#include "sched_stride.h"
+#elif SCHED_POLICY == SCHED_POLICY_CYCLIC
+#include "sched_cyclic.h"
+#else
+#error "unknown SCHED_POLICY"
+#endif
+
+/* Bring the ready sets in line with the tasks marked in sched_dirty since
+ * the last pass, whose states syscalls, wake-ups and throttling changed */
+static inline void sched_sync(void)
+{
+	xTask *task;
+	int runnable;
+
+	while (sched_dirty) {
+		task = &user_task[__builtin_ctz(sched_dirty)];
+		sched_dirty &= sched_dirty - 1;
+		if (task->sched_class == SCHED_EDF)
+			edf_sync(task);
+		runnable = sched_runnable(task);
+		if (runnable && !task->sch_queued) {
+			task->sch_queued = 1;
+			sched_enqueue(task);
+		} else if (!runnable && task->sch_queued) {
+			task->sch_queued = 0;
+			sched_dequeue(task);
+		}
+	}
+}
+
+#endif
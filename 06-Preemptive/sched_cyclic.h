@@ -0,0 +1,72 @@
+#ifndef __SCHED_CYCLIC_H_
+#define __SCHED_CYCLIC_H_
+
+/*
+ * Time-triggered cyclic executive. The tick selects the current minor
+ * frame and cyclic_table.h says which task owns it, so picking is a single
+ * table lookup. A task finishes its work for the frame by trapping into the
+ * kernel (syscall(), task_wait_next_period(), ...) and is not dispatched
+ * again before its next frame. A task still running when the tick ends its
+ * frame has overrun it; that is counted in frame_overruns.
+ */
+
+#include "cyclic_table.h"
+
+#define CYCLIC_ENTRY(task)	(task),
+static const unsigned char cyclic_table[] = { CYCLIC_TABLE(CYCLIC_ENTRY) };
+
+/* Tasks owning a frame, one bit per index, usable in #if */
+#define CYCLIC_BIT(task)	| ((task) == CYCLIC_IDLE ? 0 : 1U << ((task) & 31))
+#define CYCLIC_TASK_MASK	(0 CYCLIC_TABLE(CYCLIC_BIT))
+
+#define CYCLIC_FRAMES	(sizeof(cyclic_table) / sizeof(cyclic_table[0]))
+
+/* Absolute number of the frame each task last completed work in, plus one */
+static unsigned int cyclic_done[TASK_LIMIT];
+static unsigned int cyclic_dispatched;
+
+static inline __ramfunc unsigned int cyclic_frame(void)
+{
+	return os_ticks / CYCLIC_MINOR_TICKS;
+}
+
+static inline void sched_enqueue(xTask *task)
+{
+}
+
+static inline void sched_dequeue(xTask *task)
+{
+}
+
+static inline __ramfunc xTask *sched_pick_next(void)
+{
+	unsigned int frame = cyclic_frame();
+	unsigned int slot = cyclic_table[frame % CYCLIC_FRAMES];
+	xTask *task;
+
+	if (slot == CYCLIC_IDLE || slot >= nr_tasks || cyclic_done[slot] == frame + 1)
+		return NULL;
+	task = &user_task[slot];
+	if (!sched_runnable(task))
+		return NULL;
+	task->sch_queued = 0;
+	cyclic_dispatched = frame;
+	return task;
+}
+
+static inline void sched_tick(xTask *task, unsigned int elapsed, unsigned int cycles)
+{
+	if (cyclic_frame() != cyclic_dispatched)
+		task_info(task)->frame_overruns++;
+}
+
+static inline void sched_yield(xTask *task, unsigned int cycles)
+{
+	cyclic_done[task - user_task] = cyclic_dispatched + 1;
+}
+
+static inline void sched_reprioritise(xTask *task)
+{
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef __SCHED_MLFQ_H_
+#define __SCHED_MLFQ_H_
+
+/*
+ * Multilevel feedback queue. Level 0 is the most urgent and has the
+ * shortest quantum; each level is a round-robin FIFO.
+ *  - A task that uses up its level's quantum drops one level. Use is
+ *    counted in core cycles, for runs that end in a tick, a yield or a
+ *    syscall alike, so yielding just before the tick does not game the
+ *    policy.
+ *  - A task preempted with quantum left goes back to the head of its level
+ *    and carries on with the rest of it.
+ *  - A task that blocks within a tick's worth of its quantum moves up one
+ *    level; one that merely yields keeps its level and what it consumed.
+ *  - Every MLFQ_BOOST_TICKS all tasks go back to level 0 so CPU bound tasks
+ *    cannot starve.
+ */
+
+#include "clock.h"
+
+#define MLFQ_LEVELS		3
+#define MLFQ_BOOST_TICKS	16
+
+/* Quantum of each level in ticks */
+static const unsigned int mlfq_quantum[MLFQ_LEVELS] = { 1, 2, 4 };
+
+/* Core cycles in a tick, mlfq_used counts these */
+#define MLFQ_TICK_CYCLES	(clock_tick_reload() + 1)
+
+static struct task_queue mlfq_queue[MLFQ_LEVELS];
+static unsigned int mlfq_last_boost;
+
+static inline void sched_enqueue(xTask *task)
+{
+	task_queue_push(&mlfq_queue[task->mlfq_level], task);
+}
+
+static inline void sched_dequeue(xTask *task)
+{
+	task_queue_remove(&mlfq_queue[task->mlfq_level], task);
+}
+
+static inline __ramfunc xTask *sched_pick_next(void)
+{
+	unsigned int level;
+	xTask *task;
+
+	for (level = 0; level < MLFQ_LEVELS; level++) {
+		task = task_queue_pop(&mlfq_queue[level]);
+		if (task) {
+			task->sch_queued = 0;
+			return task;
+		}
+	}
+	return NULL;
+}
+
+static inline void mlfq_boost(void)
+{
+	size_t i;
+	xTask *task;
+
+	for (i = 0; i < nr_tasks; i++) {
+		task = &user_task[i];
+		if (task->sch_queued)
+			sched_dequeue(task);
+		task->mlfq_level = 0;
+		task->mlfq_used = 0;
+		if (task->sch_queued)
+			sched_enqueue(task);
+	}
+	mlfq_last_boost = os_ticks;
+}
+
+static inline void mlfq_check_boost(void)
+{
+	if (os_ticks - mlfq_last_boost >= MLFQ_BOOST_TICKS)
+		mlfq_boost();
+}
+
+/* Charge a run to the task's quantum, returns whether that used it up */
+static inline int mlfq_charge(xTask *task, unsigned int cycles)
+{
+	task->mlfq_used += cycles;
+	if (task->mlfq_used < mlfq_quantum[task->mlfq_level] * MLFQ_TICK_CYCLES)
+		return 0;
+	if (task->mlfq_level < MLFQ_LEVELS - 1)
+		task->mlfq_level++;
+	task->mlfq_used = 0;
+	return 1;
+}
+
+static inline void sched_tick(xTask *task, unsigned int elapsed, unsigned int cycles)
+{
+	if (!mlfq_charge(task, cycles) && task->state == READY && !task->sch_queued) {
+		/* finish the quantum before the rest of the level gets a turn */
+		task->sch_queued = 1;
+		task_queue_push_front(&mlfq_queue[task->mlfq_level], task);
+	}
+	mlfq_check_boost();
+}
+
+static inline void sched_yield(xTask *task, unsigned int cycles)
+{
+	if (!mlfq_charge(task, cycles) && task->state != READY) {
+		if (task->mlfq_used < MLFQ_TICK_CYCLES && task->mlfq_level)
+			task->mlfq_level--;
+		task->mlfq_used = 0;
+	}
+	mlfq_check_boost();
+}
+
+static inline void sched_reprioritise(xTask *task)
+{
+}
+
+#endif
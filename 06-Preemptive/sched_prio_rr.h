@@ -0,0 +1,103 @@
+#ifndef __SCHED_PRIO_RR_H_
+#define __SCHED_PRIO_RR_H_
+
+/*
+ * Priority based with round-robin 2 level scheduler, the original policy.
+ * Level 1 picks the highest priority READY task not yet scheduled in the
+ * current round, level 2 starts a new round once no ready task is left
+ * that has not had its turn; blocked tasks do not hold the round open.
+ * The ready set is a mask of task indexes, so level 1 only looks at
+ * runnable tasks.
+ * Periodic tasks (periodic.h) take no part in the round: a released job
+ * runs on its rate monotonic priority alone, rather than after every other
+ * task has had its turn.
+ */
+
+/* Priority aging: every tick a READY task spends waiting raises its effective
+ * priority by one, up to AGING_CEILING, and being dispatched resets it.
+ * Disabled unless built with `make AGING_CEILING=<priority>`.
+ */
+#ifndef AGING_CEILING
+#define AGING_CEILING	0
+#endif
+
+static unsigned int prio_rr_ready;
+
+static inline __ramfunc unsigned int effective_priority(xTask *task)
+{
+#if AGING_CEILING
+	unsigned int aged = task->priority + (os_ticks - task->ready_since);
+
+	if (task->priority < AGING_CEILING)
+		return aged < AGING_CEILING ? aged : AGING_CEILING;
+#endif
+	return task->priority;
+}
+
+static inline void sched_enqueue(xTask *task)
+{
+	prio_rr_ready |= 1U << (task - user_task);
+}
+
+static inline void sched_dequeue(xTask *task)
+{
+	prio_rr_ready &= ~(1U << (task - user_task));
+}
+
+static inline void prio_rr_new_round(void)
+{
+	size_t i;
+
+	for (i = 0; i < nr_tasks; i++)
+		user_task[i].sch_state = UNSCHEDULED;
+}
+
+/* Highest priority ready task still due a turn, the lowest index on a tie */
+static inline __ramfunc xTask *prio_rr_scan(void)
+{
+	unsigned int ready = prio_rr_ready;
+	xTask *best = NULL;
+	xTask *task;
+
+	while (ready) {
+		task = &user_task[__builtin_ctz(ready)];
+		ready &= ready - 1;
+		if (!sched_runnable(task) ||
+		    (task->sch_state == SCHEDULED && !task->rm.period))
+			continue;
+		if (!best || effective_priority(task) > effective_priority(best))
+			best = task;
+	}
+	return best;
+}
+
+static inline __ramfunc xTask *sched_pick_next(void)
+{
+	xTask *task = prio_rr_scan(); //level 1
+
+	if (!task) { //level 2: round robin
+		prio_rr_new_round();
+		task = prio_rr_scan();
+		if (!task)
+			return NULL;
+	}
+	task->sch_state = SCHEDULED;
+	task->sch_queued = 0;
+	sched_dequeue(task);
+	return task;
+}
+
+static inline void sched_tick(xTask *task, unsigned int elapsed, unsigned int cycles)
+{
+}
+
+static inline void sched_yield(xTask *task, unsigned int cycles)
+{
+}
+
+static inline void sched_reprioritise(xTask *task)
+{
+	prio_rr_new_round();
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef __SCHED_RR_H_
+#define __SCHED_RR_H_
+
+/*
+ * Plain round-robin: one FIFO, every runnable task gets a tick in turn and
+ * priorities are ignored.
+ */
+
+static struct task_queue rr_queue;
+
+static inline void sched_enqueue(xTask *task)
+{
+	task_queue_push(&rr_queue, task);
+}
+
+static inline void sched_dequeue(xTask *task)
+{
+	task_queue_remove(&rr_queue, task);
+}
+
+static inline __ramfunc xTask *sched_pick_next(void)
+{
+	xTask *task = task_queue_pop(&rr_queue);
+
+	if (task)
+		task->sch_queued = 0;
+	return task;
+}
+
+static inline void sched_tick(xTask *task, unsigned int elapsed, unsigned int cycles)
+{
+}
+
+static inline void sched_yield(xTask *task, unsigned int cycles)
+{
+}
+
+static inline void sched_reprioritise(xTask *task)
+{
+}
+
+#endif
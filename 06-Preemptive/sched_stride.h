@@ -0,0 +1,106 @@
+#ifndef __SCHED_STRIDE_H_
+#define __SCHED_STRIDE_H_
+
+/*
+ * Stride scheduling: CPU time is shared in proportion to tickets. Each task
+ * advances its pass by STRIDE1 / tickets for every tick it runs and the
+ * task with the lowest pass runs next, taken from a min-heap in O(log n).
+ * A task that has no tickets set gets priority + 1.
+ *
+ * Every STRIDE_WINDOW_TICKS the ticks each task actually ran are turned
+ * into stride_share, its share of the window in parts per thousand.
+ */
+
+#include "task_order.h"
+
+#define STRIDE1			(1 << 16)
+#define STRIDE_WINDOW_TICKS	100
+
+static struct task_heap stride_ready;
+static unsigned int stride_global_pass;
+static unsigned int stride_window_start;
+
+static inline unsigned int stride_of(xTask *task)
+{
+	return STRIDE1 / (task->tickets ? task->tickets : task->priority + 1);
+}
+
+static inline __ramfunc int stride_before(xTask *a, xTask *b)
+{
+	return (int) (a->stride_pass - b->stride_pass) < 0;
+}
+
+TASK_HEAP_DEFINE(stride_heap, stride_before, stride_index)
+
+static inline void sched_enqueue(xTask *task)
+{
+	/* no credit for the time spent blocked */
+	if ((int) (task->stride_pass - stride_global_pass) < 0)
+		task->stride_pass = stride_global_pass;
+	stride_heap_insert(&stride_ready, task);
+}
+
+static inline __ramfunc void sched_dequeue(xTask *task)
+{
+	stride_heap_remove(&stride_ready, task);
+}
+
+static inline __ramfunc xTask *sched_pick_next(void)
+{
+	xTask *task;
+
+	if (!stride_ready.size)
+		return NULL;
+	task = stride_ready.slot[0];
+	sched_dequeue(task);
+	task->sch_queued = 0;
+	stride_global_pass = task->stride_pass;
+	return task;
+}
+
+static inline void stride_account(xTask *task, unsigned int elapsed)
+{
+	size_t i;
+	unsigned int window = os_ticks - stride_window_start;
+
+	/* a dispatch that ends before the tick still costs one stride */
+	task->stride_last = stride_of(task);
+	task->stride_pass += task->stride_last * (elapsed ? elapsed : 1);
+	task->stride_run += elapsed;
+
+	if (window < STRIDE_WINDOW_TICKS)
+		return;
+	for (i = 0; i < nr_tasks; i++) {
+		user_task_info[i].stride_share = user_task[i].stride_run * 1000 / window;
+		user_task[i].stride_run = 0;
+	}
+	stride_window_start = os_ticks;
+}
+
+static inline void sched_tick(xTask *task, unsigned int elapsed, unsigned int cycles)
+{
+	stride_account(task, elapsed);
+}
+
+static inline void sched_yield(xTask *task, unsigned int cycles)
+{
+	stride_account(task, 0);
+}
+
+/* Tickets or priority changed: rescale the pass still owed to the new stride */
+static inline void sched_reprioritise(xTask *task)
+{
+	unsigned int old_stride = task->stride_last;
+	unsigned int new_stride = stride_of(task);
+	int remain = task->stride_pass - stride_global_pass;
+
+	if (old_stride && remain > 0)
+		task->stride_pass = stride_global_pass + (unsigned int) remain / old_stride * new_stride;
+	task->stride_last = new_stride;
+	if (task->sch_queued) {
+		sched_dequeue(task);
+		sched_enqueue(task);
+	}
+}
+
+#endif
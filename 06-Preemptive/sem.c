@@ -0,0 +1,104 @@
+#include "asm.h"
+#include "sem.h"
+#include "task_order.h"
+
+/* Timed waiters of every semaphore, earliest expiry first */
+static xTask *timeouts;
+
+void sem_init(semaphore_t *sem, unsigned int count)
+{
+	sem->count = count;
+	sem->waiters = NULL;
+}
+
+static void unlink_task(xTask **list, xTask *task)
+{
+	xTask **link = list;
+
+	while (*link && *link != task)
+		link = &(*link)->sem_next;
+	if (*link)
+		*link = task->sem_next;
+}
+
+static void wake(xTask *task, int result)
+{
+	if (task->sem_timeout != SEM_FOREVER)
+		TICK_LIST_REMOVE(&timeouts, task, sem_timeout_next);
+	task->sem_waiting = NULL;
+	task->task_address[FRAME_R0] = result;
+	task_wake(task);
+}
+
+static void give(semaphore_t *sem)
+{
+	xTask *task = sem->waiters;
+
+	if (!task) {
+		sem->count++;
+		return;
+	}
+	sem->waiters = task->sem_next;
+	wake(task, SEM_OK);
+}
+
+static void block(xTask *task, semaphore_t *sem, unsigned int timeout)
+{
+	xTask **link = &sem->waiters;
+
+	while (*link && (*link)->priority >= task->priority)
+		link = &(*link)->sem_next;
+	task->sem_next = *link;
+	*link = task;
+
+	task->sem_waiting = sem;
+	task->sem_timeout = timeout;
+	if (timeout != SEM_FOREVER) {
+		task->sem_wake = os_ticks + timeout;
+		TICK_LIST_INSERT(&timeouts, task, sem_wake, sem_timeout_next);
+	}
+	task->state = WAITING;
+}
+
+/* Handle a sem_call() trap from `task` */
+int sem_syscall(xTask *task, unsigned int op, semaphore_t *sem, unsigned int timeout)
+{
+	if (op == SEM_GIVE) {
+		give(sem);
+		return SEM_OK;
+	}
+	if (sem->count) {
+		sem->count--;
+		return SEM_OK;
+	}
+	if (!timeout)
+		return SEM_TIMEOUT;
+	block(task, sem, timeout);
+	return SEM_OK;
+}
+
+/* Fail the waits that have expired, called once per scheduler pass */
+void sem_poll(void)
+{
+	xTask *task;
+
+	while ((task = timeouts) && (int) (os_ticks - task->sem_wake) >= 0) {
+		unlink_task(&task->sem_waiting->waiters, task);
+		wake(task, SEM_TIMEOUT);
+	}
+}
+
+int sem_take(semaphore_t *sem, unsigned int timeout)
+{
+	return sem_call(SEM_TAKE, sem, timeout);
+}
+
+void sem_give(semaphore_t *sem)
+{
+	sem_call(SEM_GIVE, sem, 0);
+}
+
+void sem_give_from_isr(semaphore_t *sem)
+{
+	give(sem);
+}
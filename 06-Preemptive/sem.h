@@ -0,0 +1,40 @@
+#ifndef __SEM_H_
+#define __SEM_H_
+
+#include "os.h"
+
+/*
+ * Counting semaphores. A task that cannot take one blocks: it leaves the
+ * ready set and waits in the semaphore's queue, highest priority first and
+ * FIFO among equals. sem_give() hands the unit straight to the first
+ * waiter instead of bumping the count. Waits with a timeout also sit in one
+ * list sorted by expiry, so checking them costs nothing until one is due.
+ */
+
+#define SEM_FOREVER	0xFFFFFFFF
+
+#define SEM_OK		0
+#define SEM_TIMEOUT	(-1)
+
+typedef struct semaphore {
+	unsigned int count;
+	xTask *waiters;
+} semaphore_t;
+
+typedef enum SEM_OP {
+	SEM_TAKE,
+	SEM_GIVE
+} SEM_OP;
+
+void sem_init(semaphore_t *sem, unsigned int count);
+
+/* Returns SEM_OK, or SEM_TIMEOUT after `timeout` ticks (0 polls) */
+int sem_take(semaphore_t *sem, unsigned int timeout);
+void sem_give(semaphore_t *sem);
+void sem_give_from_isr(semaphore_t *sem);
+
+/* Kernel side */
+int sem_syscall(xTask *task, unsigned int op, semaphore_t *sem, unsigned int timeout);
+void sem_poll(void);
+
+#endif
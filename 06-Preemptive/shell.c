@@ -0,0 +1,219 @@
+#include <string.h>
+#include "os.h"
+#include "clock.h"
+#include "governor.h"
+#include "usart.h"
+#include "heap.h"
+#include "pool.h"
+#include "workqueue.h"
+#include "swtimer.h"
+#include "shell.h"
+
+static const char *state_name[] = {
+	[WAITING] = "WAITING",
+	[RUNNING] = "RUNNING",
+	[READY] = "READY",
+	[SUSPENDED] = "SUSPENDED",
+	[CREATED] = "CREATED",
+	[TERMINATED] = "TERMINATED",
+};
+
+/* Returns -1 unless str is a decimal number */
+static int parse_uint(const char *str)
+{
+	int n = 0;
+
+	if (!*str)
+		return -1;
+	for (; *str; str++) {
+		if (*str < '0' || *str > '9')
+			return -1;
+		n = n * 10 + *str - '0';
+	}
+	return n;
+}
+
+static xTask *parse_task(const char *str)
+{
+	int id = parse_uint(str);
+
+	if (id < 0 || id >= nr_tasks) {
+		print_str("no such task\n");
+		return NULL;
+	}
+	return &user_task[id];
+}
+
+static void print_permille(unsigned int n)
+{
+	print_int(n / 10);
+	print_str(".");
+	print_int(n % 10);
+	print_str("%");
+}
+
+static void cmd_ps(void)
+{
+	size_t i;
+	xTask *task;
+	TASK_STATE state;
+
+	print_str("ID\tSTATE\t\tPRIO\tCPU\tSTACK\tNAME\n");
+	for (i = 0; i < nr_tasks; i++) {
+		task = &user_task[i];
+		print_int(i);
+		print_str("\t");
+		state = task->suspended ? SUSPENDED : task->state;
+		print_str(state_name[state]);
+		print_str(strlen(state_name[state]) < 8 ? "\t\t" : "\t");
+		print_int(task->priority);
+		print_str("\t");
+		print_permille(task_info(task)->cpu_load);
+		print_str("\t");
+		print_int(Task_stack_high_water(task));
+		print_str("/");
+		print_int(STACK_SIZE * sizeof(unsigned int));
+		print_str("\t");
+		print_str(task_info(task)->task_name);
+		print_str("\n");
+	}
+}
+
+static void print_counter(const char *name, unsigned int value)
+{
+	print_str(name);
+	print_str(": ");
+	print_int(value);
+	print_str("\n");
+}
+
+static void cmd_stat(void)
+{
+	tlsf_stats_t heap;
+	pool_t *pool;
+	size_t i;
+
+	print_counter("ticks", os_ticks);
+	print_str("clock: ");
+	print_str(clock_profiles[clock_profile()].name);
+	print_str(", load ");
+	print_permille(governor_load());
+	print_str("\n");
+	print_counter("clock switches", governor_switches());
+	print_counter("sched passes", sched_stats.passes);
+	print_counter("sched pass last cycles", sched_stats.pass_cycles_last);
+	print_counter("sched pass max cycles", sched_stats.pass_cycles_max);
+	for (i = 0; i < nr_tasks; i++) {
+		print_str("max wait ");
+		print_str(task_info(&user_task[i])->task_name);
+		print_str(": ");
+		print_int(task_info(&user_task[i])->max_wait_ticks);
+		print_str("\n");
+	}
+
+	print_counter("usart baud", usart_baud());
+	print_counter("usart tx bytes", usart_stats.tx_bytes);
+	print_counter("usart tx stalls", usart_stats.tx_stalls);
+	print_counter("usart rx bytes", usart_stats.rx_bytes);
+	print_counter("usart rx overruns", usart_stats.rx_overruns);
+	print_counter("usart rx drops", usart_stats.rx_drops);
+	print_counter("usart rx errors", usart_stats.rx_errors);
+
+	print_counter("work queued", workqueue_stats.queued);
+	print_counter("work coalesced", workqueue_stats.coalesced);
+	print_counter("work run", workqueue_stats.run);
+	print_counter("work batches", workqueue_stats.batches);
+	print_counter("work max batch", workqueue_stats.max_batch);
+	print_counter("work depth", workqueue_stats.depth);
+	print_counter("work max depth", workqueue_stats.max_depth);
+	print_counter("work latency avg cycles", workqueue_stats.latency_avg);
+	print_counter("work latency max cycles", workqueue_stats.latency_max);
+
+	print_counter("timers expired", swtimer_stats.expired);
+	print_counter("timer batches", swtimer_stats.batches);
+	print_counter("timer max batch", swtimer_stats.max_batch);
+	print_counter("timer periods missed", swtimer_stats.missed);
+	print_counter("timer latency max ticks", swtimer_stats.latency_max);
+	print_counter("timer callback max cycles", swtimer_stats.run_cycles_max);
+
+	heap_get_stats(&heap);
+	print_counter("heap used", heap.used_bytes);
+	print_counter("heap peak", heap.peak_used_bytes);
+	print_counter("heap free", heap.free_bytes);
+	print_counter("heap largest free", heap.largest_free);
+	print_counter("heap fragmentation per mille", heap.fragmentation);
+	print_counter("heap failures", heap.failures);
+
+	for (pool = pool_first(); pool < pool_end(); pool++) {
+		print_str("pool ");
+		print_str(pool->name);
+		print_str(": ");
+		print_int(pool->used);
+		print_str(" used, high water ");
+		print_int(pool->high_water);
+		print_str(" of ");
+		print_int(pool->nr_blocks);
+		print_str(", failures ");
+		print_int(pool->failures);
+		print_str("\n");
+	}
+}
+
+static void cmd_help(void)
+{
+	print_str("ps | prio <id> <prio> | suspend <id> | resume <id> | stat\n");
+}
+
+static void run(int argc, char *argv[])
+{
+	xTask *task;
+	int prio;
+
+	if (!strcmp(argv[0], "ps")) {
+		cmd_ps();
+	} else if (!strcmp(argv[0], "stat")) {
+		cmd_stat();
+	} else if (!strcmp(argv[0], "prio") && argc == 3) {
+		task = parse_task(argv[1]);
+		prio = parse_uint(argv[2]);
+		if (task && prio >= 0)
+			Task_modify_priority(task, prio);
+	} else if (!strcmp(argv[0], "suspend") && argc == 2) {
+		task = parse_task(argv[1]);
+		if (task)
+			Task_suspend(task);
+	} else if (!strcmp(argv[0], "resume") && argc == 2) {
+		task = parse_task(argv[1]);
+		if (task && task->suspended)
+			Task_resume(task);
+	} else {
+		cmd_help();
+	}
+}
+
+void shell_task(void)
+{
+	char line[SHELL_LINE];
+	char *argv[SHELL_ARGS];
+	char *p;
+	int argc;
+
+	while (1) {
+		print_str("> ");
+		usart_readline(line, sizeof(line));
+
+		/* split on spaces in place */
+		argc = 0;
+		for (p = line; *p && argc < SHELL_ARGS; ) {
+			while (*p == ' ')
+				*p++ = '\0';
+			if (!*p)
+				break;
+			argv[argc++] = p;
+			while (*p && *p != ' ')
+				p++;
+		}
+		if (argc)
+			run(argc, argv);
+	}
+}
@@ -0,0 +1,25 @@
+#ifndef __SHELL_H_
+#define __SHELL_H_
+
+/*
+ * On-target shell on USART2, for inspecting a live node:
+ *
+ *   ps                   tasks with state, priority, CPU use and stack high-water
+ *   prio <id> <prio>     change a task's priority
+ *   suspend <id>         suspend a task
+ *   resume <id>          make a suspended task READY again
+ *   stat                 kernel, clock, UART, work queue, timer, heap and
+ *                        pool counters
+ *
+ * The shell task must be attached as the USART2 reader, see usart.h.
+ */
+
+/* Longest command line */
+#define SHELL_LINE	64
+
+/* Words per command line */
+#define SHELL_ARGS	4
+
+void shell_task(void);
+
+#endif
@@ -1,25 +1,6 @@
 #include <stdint.h>
 #include "reg.h"
 
-/* Bit definition for RCC_CR register */
-#define RCC_CR_HSION	((uint32_t) 0x00000001)		/*!< Internal High Speed clock enable */
-#define RCC_CR_HSEON	((uint32_t) 0x00010000)		/*!< External High Speed clock enable */
-#define RCC_CR_HSERDY	((uint32_t) 0x00020000)		/*!< External High Speed clock ready flag */
-#define RCC_CR_CSSON	((uint32_t) 0x00080000)		/*!< Clock Security System enable */
-
-/* Bit definition for RCC_CFGR register */
-#define  RCC_CFGR_SW		((uint32_t) 0x00000003)	/*!< SW[1:0] bits (System clock Switch) */
-#define  RCC_CFGR_SW_HSE	((uint32_t) 0x00000001)	/*!< HSE selected as system clock */
-#define  RCC_CFGR_SWS		((uint32_t) 0x0000000C)	/*!< SWS[1:0] bits (System Clock Switch Status) */
-#define  RCC_CFGR_HPRE_DIV1	((uint32_t) 0x00000000)	/*!< SYSCLK not divided */
-#define  RCC_CFGR_PPRE1_DIV1	((uint32_t) 0x00000000)	/*!< HCLK not divided */
-#define  RCC_CFGR_PPRE2_DIV1	((uint32_t) 0x00000000)	/*!< HCLK not divided */
-
-/* Bit definition for FLASH_ACR register */
-#define FLASH_ACR_LATENCY	((uint8_t) 0x03)	/*!< LATENCY[2:0] bits (Latency) */
-#define FLASH_ACR_LATENCY_0	((uint8_t) 0x00)	/*!< Bit 0 */
-#define FLASH_ACR_PRFTBE	((uint8_t) 0x10)	/*!< Prefetch Buffer Enable */
-
 #define HSE_STARTUP_TIMEOUT	((uint16_t) 0x0500)	/*!< Time out for HSE start up */
 
 /* main program entry point */
@@ -32,6 +13,10 @@ extern uint32_t _sidata;
 extern uint32_t _sdata;
 /* end address for the .data section. defined in linker script */
 extern uint32_t _edata;
+/* load address, start and end of the .ramfunc section. defined in linker script */
+extern uint32_t _siramfunc;
+extern uint32_t _sramfunc;
+extern uint32_t _eramfunc;
 /* start address for the .bss section. defined in linker script */
 extern uint32_t _sbss;
 /* end address for the .bss section. defined in linker script */
@@ -49,6 +34,12 @@ void reset_handler(void)
 	uint32_t *data_end = &_edata;
 	while (data_begin < data_end) *data_begin++ = *idata_begin++;
 
+	/* Copy the code that runs from SRAM */
+	uint32_t *iramfunc_begin = &_siramfunc;
+	uint32_t *ramfunc_begin = &_sramfunc;
+	uint32_t *ramfunc_end = &_eramfunc;
+	while (ramfunc_begin < ramfunc_end) *ramfunc_begin++ = *iramfunc_begin++;
+
 	/* Zero fill the bss segment. */
 	uint32_t *bss_begin = &_sbss;
 	uint32_t *bss_end = &_ebss;
@@ -73,6 +64,7 @@ void usagefault_handler(void) __attribute((weak, alias("default_handler")));
 void svc_handler(void) __attribute((weak, alias("default_handler")));
 void pendsv_handler(void) __attribute((weak, alias("default_handler")));
 void systick_handler(void) __attribute((weak, alias("default_handler")));
+void usart2_irq_handler(void) __attribute((weak, alias("default_handler")));
 
 __attribute((section(".isr_vector")))
 uint32_t *isr_vectors[] = {
@@ -91,7 +83,11 @@ uint32_t *isr_vectors[] = {
 	0,
 	0,
 	(uint32_t *) pendsv_handler,		/* pendsv handler */
-	(uint32_t *) systick_handler		/* systick handler */
+	(uint32_t *) systick_handler,		/* systick handler */
+
+	/* external interrupts */
+	[16 ... 16 + IRQ_COUNT - 1] = (uint32_t *) default_handler,
+	[16 + USART2_IRQn] = (uint32_t *) usart2_irq_handler,	/* USART2 global interrupt */
 };
 
 void rcc_clock_init(void)
@@ -157,7 +153,7 @@ void rcc_clock_init(void)
 		*RCC_CFGR |= (uint32_t) RCC_CFGR_SW_HSE;
 
 		/* Wait till HSE is used as system clock source */
-		while ((*RCC_CFGR & (uint32_t) RCC_CFGR_SWS) != (uint32_t) 0x04);
+		while ((*RCC_CFGR & (uint32_t) RCC_CFGR_SWS) != RCC_CFGR_SWS_HSE);
 	} else {
 		/* If HSE fails to start-up, the application will have wrong clock
 		configuration. User can add here some code to deal with this error */
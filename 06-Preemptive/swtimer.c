@@ -0,0 +1,207 @@
+#include "notify.h"
+#include "mutex.h"
+#include "pool.h"
+#include "clock.h"
+#include "swtimer.h"
+
+POOL_DEFINE(swtimer_pool, sizeof(swtimer_t), SWTIMER_MAX);
+
+struct swtimer_stats swtimer_stats;
+
+/* Guards the delta list and every timer's list fields */
+static mutex_t lock;
+static swtimer_t *head;
+/* Tick the head's delta counts from */
+static unsigned int base;
+static unsigned int daemon = -1;
+
+/* Insert so that the timer expires at tick `due`, never before `base` */
+static void list_insert(swtimer_t *timer, unsigned int due)
+{
+	swtimer_t **link = &head;
+	unsigned int left = (int) (due - base) > 0 ? due - base : 0;
+
+	while (*link && (*link)->delta <= left) {
+		left -= (*link)->delta;
+		link = &(*link)->next;
+	}
+	timer->delta = left;
+	timer->next = *link;
+	if (*link)
+		(*link)->delta -= left;
+	*link = timer;
+	timer->due = due;
+	timer->active = 1;
+}
+
+static void list_remove(swtimer_t *timer)
+{
+	swtimer_t **link = &head;
+
+	while (*link != timer)
+		link = &(*link)->next;
+	*link = timer->next;
+	if (timer->next)
+		timer->next->delta += timer->delta;
+	timer->active = 0;
+}
+
+/* The head may have become due earlier, or the list empty */
+static void wake_daemon(void)
+{
+	if (daemon < nr_tasks)
+		notify_give(daemon);
+}
+
+swtimer_t *swtimer_create(const char *name, unsigned int period, unsigned int periodic,
+                          void (*callback)(swtimer_t *timer), void *arg)
+{
+	swtimer_t *timer;
+
+	if (!period || !(timer = pool_alloc(&swtimer_pool)))
+		return NULL;
+	*timer = (swtimer_t) {
+		.name = name,
+		.callback = callback,
+		.arg = arg,
+		.period = period,
+		.periodic = periodic,
+	};
+	return timer;
+}
+
+void swtimer_delete(swtimer_t *timer)
+{
+	mutex_lock(&lock);
+	if (timer->active)
+		list_remove(timer);
+	if (timer->in_batch)
+		timer->dead = 1;
+	else
+		pool_free(&swtimer_pool, timer);
+	mutex_unlock(&lock);
+}
+
+void swtimer_start(swtimer_t *timer)
+{
+	mutex_lock(&lock);
+	if (timer->active)
+		list_remove(timer);
+	list_insert(timer, os_ticks + timer->period);
+	mutex_unlock(&lock);
+	wake_daemon();
+}
+
+void swtimer_stop(swtimer_t *timer)
+{
+	mutex_lock(&lock);
+	if (timer->active)
+		list_remove(timer);
+	mutex_unlock(&lock);
+}
+
+void swtimer_change_period(swtimer_t *timer, unsigned int period)
+{
+	if (!period)
+		return;
+	mutex_lock(&lock);
+	timer->period = period;
+	mutex_unlock(&lock);
+	swtimer_start(timer);
+}
+
+void swtimer_attach(unsigned int task)
+{
+	daemon = task;
+}
+
+/* Pop every timer due by `now` into a batch in due order, re-arming the
+ * periodic ones. Returns the batch. */
+static swtimer_t *expire(unsigned int now)
+{
+	swtimer_t *batch = NULL, **tail = &batch;
+	swtimer_t *timer;
+	unsigned int elapsed = now - base;
+	unsigned int due;
+
+	base = now;
+	while (head && head->delta <= elapsed) {
+		timer = head;
+		elapsed -= timer->delta;
+		head = timer->next;
+		timer->active = 0;
+		timer->in_batch = 1;
+		timer->batch_next = NULL;
+		*tail = timer;
+		tail = &timer->batch_next;
+	}
+	if (head)
+		head->delta -= elapsed;
+
+	for (timer = batch; timer; timer = timer->batch_next) {
+		if (!timer->periodic)
+			continue;
+		due = timer->due + timer->period;
+		while ((int) (now - due) >= 0) {
+			swtimer_stats.missed++;
+			due += timer->period;
+		}
+		list_insert(timer, due);
+	}
+	return batch;
+}
+
+static void run_batch(swtimer_t *batch)
+{
+	struct swtimer_stats *st = &swtimer_stats;
+	swtimer_t *timer, *next;
+	unsigned int count = 0;
+	unsigned int latency, start, cycles;
+
+	for (timer = batch; timer; timer = next) {
+		next = timer->batch_next;
+		latency = os_ticks - timer->due;
+		st->latency_last = latency;
+		if (latency > st->latency_max)
+			st->latency_max = latency;
+
+		start = clock_now();
+		if (!timer->dead)
+			timer->callback(timer);
+		cycles = clock_now() - start;
+		if (cycles > st->run_cycles_max)
+			st->run_cycles_max = cycles;
+		count++;
+
+		mutex_lock(&lock);
+		timer->in_batch = 0;
+		if (timer->dead)
+			pool_free(&swtimer_pool, timer);
+		mutex_unlock(&lock);
+	}
+
+	st->expired += count;
+	st->batches++;
+	if (count > st->max_batch)
+		st->max_batch = count;
+}
+
+void swtimer_daemon(void)
+{
+	swtimer_t *batch;
+	unsigned int now, wait;
+
+	while (1) {
+		mutex_lock(&lock);
+		now = os_ticks;
+		batch = expire(now);
+		wait = head ? head->delta : NOTIFY_FOREVER;
+		mutex_unlock(&lock);
+
+		if (batch) {
+			run_batch(batch);
+			continue;
+		}
+		notify_take(1, wait);
+	}
+}
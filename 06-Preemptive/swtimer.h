@@ -0,0 +1,66 @@
+#ifndef __SWTIMER_H_
+#define __SWTIMER_H_
+
+#include "os.h"
+
+/*
+ * Software timers, all run by one daemon task instead of one polling task
+ * each. Armed timers sit in a delta list: each entry holds the ticks left
+ * after the entry before it, so expiring is a pop from the head and the
+ * daemon sleeps in notify_take() exactly until the head is due. Timers
+ * that come due together expire as one batch. The daemon re-arms periodic
+ * timers from their due tick, so they do not drift, then runs the
+ * callbacks in due order.
+ *
+ * Timers come from a pool of SWTIMER_MAX. The API is for tasks, including
+ * the callbacks themselves, which run on the daemon's stack and should be
+ * short. A timer stopped while its batch is running may still fire once.
+ */
+
+#define SWTIMER_MAX	8
+
+typedef struct swtimer {
+	const char *name;
+	void (*callback)(struct swtimer *timer);
+	void *arg;			/* for the callback */
+	unsigned int period;		/* ticks */
+	unsigned int periodic;
+	unsigned int active;		/* in the delta list */
+	unsigned int delta;		/* ticks after the previous entry */
+	unsigned int due;		/* tick it expires at */
+	unsigned int in_batch;		/* expired, callback not run yet */
+	unsigned int dead;		/* deleted from its own batch, freed after it */
+	struct swtimer *next;
+	struct swtimer *batch_next;
+} swtimer_t;
+
+/* Latencies are in ticks from the due tick to the callback */
+struct swtimer_stats {
+	unsigned int expired;
+	unsigned int batches;
+	unsigned int max_batch;
+	unsigned int missed;		/* periodic expiries skipped, the daemon was late */
+	unsigned int latency_last;
+	unsigned int latency_max;
+	unsigned int run_cycles_max;	/* longest callback */
+};
+
+extern struct swtimer_stats swtimer_stats;
+
+/* Returns NULL when the pool is exhausted. The timer is created stopped. */
+swtimer_t *swtimer_create(const char *name, unsigned int period, unsigned int periodic,
+                          void (*callback)(swtimer_t *timer), void *arg);
+void swtimer_delete(swtimer_t *timer);
+
+/* (Re)arm to expire `period` ticks from now */
+void swtimer_start(swtimer_t *timer);
+void swtimer_stop(swtimer_t *timer);
+
+/* Set a new period and (re)arm with it */
+void swtimer_change_period(swtimer_t *timer, unsigned int period);
+
+/* The daemon, set up from main before the scheduler starts */
+void swtimer_attach(unsigned int task);
+void swtimer_daemon(void);
+
+#endif
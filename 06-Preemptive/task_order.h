@@ -0,0 +1,107 @@
+#ifndef __TASK_ORDER_H_
+#define __TASK_ORDER_H_
+
+#include "os.h"
+
+/*
+ * Orderings the kernel keeps tasks in, shared by its timers and ready sets.
+ *
+ * A tick list is a singly linked list in ascending order of a tick field,
+ * compared so that os_ticks wrapping around does not matter; the scheduler
+ * pass pops its head while that is due. Tasks due on the same tick keep
+ * their insertion order. `key` and `next` name fields of xTask, such as
+ * edf.next_release and edf.release_next.
+ */
+#define TICK_LIST_INSERT(head, task, key, next) do {			\
+	xTask **_link = (head);						\
+									\
+	while (*_link && (int) ((*_link)->key - (task)->key) <= 0)	\
+		_link = &(*_link)->next;				\
+	(task)->next = *_link;						\
+	*_link = (task);						\
+} while (0)
+
+#define TICK_LIST_REMOVE(head, task, next) do {				\
+	xTask **_link = (head);						\
+									\
+	while (*_link && *_link != (task))				\
+		_link = &(*_link)->next;				\
+	if (*_link)							\
+		*_link = (task)->next;					\
+} while (0)
+
+/*
+ * A task heap is a binary min-heap in a fixed array. TASK_HEAP_DEFINE(name,
+ * before, index) defines name_insert() and name_remove() for a heap ordered
+ * by before(a, b), where each task keeps its slot in the field `index` so it
+ * can leave from the middle in O(log n). The top is slot[0].
+ */
+struct task_heap {
+	xTask *slot[TASK_LIMIT];
+	unsigned int size;
+};
+
+#define TASK_HEAP_DEFINE(name, before, index)				\
+static inline __ramfunc void name##_place(struct task_heap *heap,	\
+                                          unsigned int i, xTask *task)	\
+{									\
+	heap->slot[i] = task;						\
+	task->index = i;						\
+}									\
+									\
+static inline __ramfunc void name##_sift_up(struct task_heap *heap,	\
+                                            unsigned int i)		\
+{									\
+	xTask *task = heap->slot[i];					\
+	unsigned int parent;						\
+									\
+	while (i > 0) {							\
+		parent = (i - 1) / 2;					\
+		if (!before(task, heap->slot[parent]))			\
+			break;						\
+		name##_place(heap, i, heap->slot[parent]);		\
+		i = parent;						\
+	}								\
+	name##_place(heap, i, task);					\
+}									\
+									\
+static inline __ramfunc void name##_sift_down(struct task_heap *heap,	\
+                                              unsigned int i)		\
+{									\
+	xTask *task = heap->slot[i];					\
+	unsigned int child;						\
+									\
+	while ((child = 2 * i + 1) < heap->size) {			\
+		if (child + 1 < heap->size &&				\
+		    before(heap->slot[child + 1], heap->slot[child]))	\
+			child++;					\
+		if (!before(heap->slot[child], task))			\
+			break;						\
+		name##_place(heap, i, heap->slot[child]);		\
+		i = child;						\
+	}								\
+	name##_place(heap, i, task);					\
+}									\
+									\
+static inline __ramfunc void name##_insert(struct task_heap *heap,	\
+                                           xTask *task)			\
+{									\
+	name##_place(heap, heap->size, task);				\
+	heap->size++;							\
+	name##_sift_up(heap, heap->size - 1);				\
+}									\
+									\
+static inline __ramfunc void name##_remove(struct task_heap *heap,	\
+                                           xTask *task)			\
+{									\
+	unsigned int i = task->index;					\
+	xTask *last = heap->slot[--heap->size];				\
+									\
+	if (i == heap->size)						\
+		return;							\
+	name##_place(heap, i, last);					\
+	name##_sift_down(heap, i);					\
+	name##_sift_up(heap, last->index);				\
+}
+
+#endif
@@ -0,0 +1,304 @@
+#include <stdint.h>
+#include "tlsf.h"
+
+/*
+ * Block layout: `size` sits right before the payload, and the payload of a
+ * free block starts with its free list links. The last word of a block's
+ * payload doubles as prev_phys of the next block, which is why prev_phys is
+ * only meaningful while the previous block is free.
+ */
+#define BLOCK_FREE		((size_t) 1)
+#define BLOCK_PREV_FREE		((size_t) 2)
+#define BLOCK_OVERHEAD		sizeof(size_t)
+#define BLOCK_START		(offsetof(tlsf_block_t, size) + sizeof(size_t))
+#define BLOCK_SIZE_MIN		(sizeof(tlsf_block_t) - sizeof(tlsf_block_t *))
+#define BLOCK_SIZE_MAX		((size_t) 1 << TLSF_FL_MAX)
+
+static int fls(unsigned int word)
+{
+	return 31 - __builtin_clz(word);
+}
+
+static int ffs(unsigned int word)
+{
+	return __builtin_ctz(word);
+}
+
+static size_t block_size(const tlsf_block_t *block)
+{
+	return block->size & ~(BLOCK_FREE | BLOCK_PREV_FREE);
+}
+
+static void block_set_size(tlsf_block_t *block, size_t size)
+{
+	block->size = size | (block->size & (BLOCK_FREE | BLOCK_PREV_FREE));
+}
+
+static int block_is_free(const tlsf_block_t *block)
+{
+	return block->size & BLOCK_FREE;
+}
+
+static int block_is_prev_free(const tlsf_block_t *block)
+{
+	return block->size & BLOCK_PREV_FREE;
+}
+
+static tlsf_block_t *block_from_ptr(void *ptr)
+{
+	return (tlsf_block_t *) ((char *) ptr - BLOCK_START);
+}
+
+static void *block_to_ptr(tlsf_block_t *block)
+{
+	return (char *) block + BLOCK_START;
+}
+
+static tlsf_block_t *block_next(tlsf_block_t *block)
+{
+	return (tlsf_block_t *) ((char *) block_to_ptr(block) + block_size(block) - BLOCK_OVERHEAD);
+}
+
+static tlsf_block_t *block_link_next(tlsf_block_t *block)
+{
+	tlsf_block_t *next = block_next(block);
+
+	next->prev_phys = block;
+	return next;
+}
+
+static void block_mark_free(tlsf_block_t *block)
+{
+	tlsf_block_t *next = block_link_next(block);
+
+	next->size |= BLOCK_PREV_FREE;
+	block->size |= BLOCK_FREE;
+}
+
+static void block_mark_used(tlsf_block_t *block)
+{
+	tlsf_block_t *next = block_next(block);
+
+	next->size &= ~BLOCK_PREV_FREE;
+	block->size &= ~BLOCK_FREE;
+}
+
+static void mapping_insert(size_t size, int *fl, int *sl)
+{
+	if (size < TLSF_SMALL_BLOCK) {
+		*fl = 0;
+		*sl = size / (TLSF_SMALL_BLOCK / TLSF_SL_COUNT);
+	} else {
+		*fl = fls(size);
+		*sl = (size >> (*fl - TLSF_SL_LOG2)) ^ TLSF_SL_COUNT;
+		*fl -= TLSF_FL_SHIFT - 1;
+	}
+}
+
+/* Round up to the next list boundary so any block found there fits */
+static void mapping_search(size_t size, int *fl, int *sl)
+{
+	if (size >= TLSF_SMALL_BLOCK)
+		size += (1 << (fls(size) - TLSF_SL_LOG2)) - 1;
+	mapping_insert(size, fl, sl);
+}
+
+static tlsf_block_t *search_suitable_block(tlsf_t *tlsf, int *fl, int *sl)
+{
+	unsigned int sl_map = tlsf->sl_bitmap[*fl] & (~0U << *sl);
+	unsigned int fl_map;
+
+	if (!sl_map) {
+		fl_map = tlsf->fl_bitmap & (~0U << (*fl + 1));
+		if (!fl_map)
+			return NULL;
+		*fl = ffs(fl_map);
+		sl_map = tlsf->sl_bitmap[*fl];
+	}
+	*sl = ffs(sl_map);
+	return tlsf->blocks[*fl][*sl];
+}
+
+static void remove_free_block(tlsf_t *tlsf, tlsf_block_t *block, int fl, int sl)
+{
+	tlsf_block_t *prev = block->prev_free;
+	tlsf_block_t *next = block->next_free;
+
+	next->prev_free = prev;
+	prev->next_free = next;
+	if (tlsf->blocks[fl][sl] == block) {
+		tlsf->blocks[fl][sl] = next;
+		if (next == &tlsf->null_block) {
+			tlsf->sl_bitmap[fl] &= ~(1U << sl);
+			if (!tlsf->sl_bitmap[fl])
+				tlsf->fl_bitmap &= ~(1U << fl);
+		}
+	}
+}
+
+static void insert_free_block(tlsf_t *tlsf, tlsf_block_t *block, int fl, int sl)
+{
+	tlsf_block_t *current = tlsf->blocks[fl][sl];
+
+	block->next_free = current;
+	block->prev_free = &tlsf->null_block;
+	current->prev_free = block;
+	tlsf->blocks[fl][sl] = block;
+	tlsf->fl_bitmap |= 1U << fl;
+	tlsf->sl_bitmap[fl] |= 1U << sl;
+}
+
+static void block_remove(tlsf_t *tlsf, tlsf_block_t *block)
+{
+	int fl, sl;
+
+	mapping_insert(block_size(block), &fl, &sl);
+	remove_free_block(tlsf, block, fl, sl);
+}
+
+static void block_insert(tlsf_t *tlsf, tlsf_block_t *block)
+{
+	int fl, sl;
+
+	mapping_insert(block_size(block), &fl, &sl);
+	insert_free_block(tlsf, block, fl, sl);
+}
+
+/* Cut `size` bytes off the front of block, return the free remainder */
+static tlsf_block_t *block_split(tlsf_block_t *block, size_t size)
+{
+	tlsf_block_t *remaining = (tlsf_block_t *) ((char *) block_to_ptr(block) + size - BLOCK_OVERHEAD);
+
+	remaining->size = 0;
+	block_set_size(remaining, block_size(block) - (size + BLOCK_OVERHEAD));
+	block_set_size(block, size);
+	block_mark_free(remaining);
+	return remaining;
+}
+
+static tlsf_block_t *block_absorb(tlsf_block_t *prev, tlsf_block_t *block)
+{
+	prev->size += block_size(block) + BLOCK_OVERHEAD;
+	block_link_next(prev);
+	return prev;
+}
+
+static size_t adjust_request_size(size_t size)
+{
+	size_t adjusted;
+
+	if (!size || size >= BLOCK_SIZE_MAX)
+		return 0;
+	adjusted = (size + TLSF_ALIGN - 1) & ~(size_t) (TLSF_ALIGN - 1);
+	return adjusted < BLOCK_SIZE_MIN ? BLOCK_SIZE_MIN : adjusted;
+}
+
+void tlsf_init(tlsf_t *tlsf, void *pool, size_t bytes)
+{
+	tlsf_block_t *block;
+	tlsf_block_t *next;
+	size_t pool_bytes;
+	int i, j;
+
+	tlsf->null_block.next_free = &tlsf->null_block;
+	tlsf->null_block.prev_free = &tlsf->null_block;
+	tlsf->fl_bitmap = 0;
+	for (i = 0; i < TLSF_FL_COUNT; i++) {
+		tlsf->sl_bitmap[i] = 0;
+		for (j = 0; j < TLSF_SL_COUNT; j++)
+			tlsf->blocks[i][j] = &tlsf->null_block;
+	}
+
+	/* one free block spanning the pool, then a zero-sized used sentinel */
+	pool_bytes = (bytes - 2 * BLOCK_OVERHEAD) & ~(size_t) (TLSF_ALIGN - 1);
+	if (pool_bytes > BLOCK_SIZE_MAX - TLSF_SMALL_BLOCK)
+		pool_bytes = BLOCK_SIZE_MAX - TLSF_SMALL_BLOCK;
+	block = (tlsf_block_t *) ((char *) pool - BLOCK_OVERHEAD);
+	block->size = pool_bytes | BLOCK_FREE;
+	block_insert(tlsf, block);
+
+	next = block_link_next(block);
+	next->size = BLOCK_PREV_FREE;
+
+	tlsf->pool = pool;
+	tlsf->stats = (tlsf_stats_t) {
+		.pool_bytes = pool_bytes,
+	};
+}
+
+void *tlsf_malloc(tlsf_t *tlsf, size_t size)
+{
+	size_t adjusted = adjust_request_size(size);
+	tlsf_block_t *block = NULL;
+	tlsf_block_t *remaining;
+	int fl, sl;
+
+	if (adjusted) {
+		mapping_search(adjusted, &fl, &sl);
+		if (fl < TLSF_FL_COUNT)
+			block = search_suitable_block(tlsf, &fl, &sl);
+	}
+	if (!block || block == &tlsf->null_block) {
+		tlsf->stats.failures++;
+		return NULL;
+	}
+	remove_free_block(tlsf, block, fl, sl);
+
+	if (block_size(block) >= sizeof(tlsf_block_t) + adjusted) {
+		remaining = block_split(block, adjusted);
+		block_link_next(block);
+		remaining->size |= BLOCK_PREV_FREE;
+		block_insert(tlsf, remaining);
+	}
+	block_mark_used(block);
+
+	tlsf->stats.allocs++;
+	tlsf->stats.used_bytes += block_size(block);
+	if (tlsf->stats.used_bytes > tlsf->stats.peak_used_bytes)
+		tlsf->stats.peak_used_bytes = tlsf->stats.used_bytes;
+	return block_to_ptr(block);
+}
+
+void tlsf_free(tlsf_t *tlsf, void *ptr)
+{
+	tlsf_block_t *block;
+	tlsf_block_t *next;
+
+	if (!ptr)
+		return;
+	block = block_from_ptr(ptr);
+	tlsf->stats.frees++;
+	tlsf->stats.used_bytes -= block_size(block);
+
+	block_mark_free(block);
+	if (block_is_prev_free(block)) {
+		block_remove(tlsf, block->prev_phys);
+		block = block_absorb(block->prev_phys, block);
+	}
+	next = block_next(block);
+	if (block_is_free(next)) {
+		block_remove(tlsf, next);
+		block = block_absorb(block, next);
+	}
+	block_insert(tlsf, block);
+}
+
+void tlsf_get_stats(tlsf_t *tlsf, tlsf_stats_t *stats)
+{
+	tlsf_block_t *block = (tlsf_block_t *) ((char *) tlsf->pool - BLOCK_OVERHEAD);
+
+	*stats = tlsf->stats;
+	stats->free_bytes = 0;
+	stats->largest_free = 0;
+	stats->free_blocks = 0;
+	for (; block_size(block); block = block_next(block)) {
+		if (!block_is_free(block))
+			continue;
+		stats->free_bytes += block_size(block);
+		stats->free_blocks++;
+		if (block_size(block) > stats->largest_free)
+			stats->largest_free = block_size(block);
+	}
+	stats->fragmentation = stats->free_bytes ?
+	                       (stats->free_bytes - stats->largest_free) * 1000 / stats->free_bytes : 0;
+}
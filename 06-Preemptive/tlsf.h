@@ -0,0 +1,60 @@
+#ifndef __TLSF_H_
+#define __TLSF_H_
+
+#include <stddef.h>
+
+/*
+ * Two-level segregated fit allocator. Free blocks are kept in one list per
+ * size class: the first level splits sizes by powers of two, the second
+ * level splits each power of two into TLSF_SL_COUNT ranges. Two bitmaps
+ * record which lists are non-empty, so finding a fitting block, splitting
+ * it and coalescing on free all take a bounded number of steps (a couple
+ * of CLZ instructions) whatever the heap looks like.
+ */
+
+#define TLSF_ALIGN_LOG2		2
+#define TLSF_ALIGN		(1 << TLSF_ALIGN_LOG2)
+#define TLSF_SL_LOG2		4
+#define TLSF_SL_COUNT		(1 << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT		(TLSF_SL_LOG2 + TLSF_ALIGN_LOG2)
+#define TLSF_FL_MAX		16	/* largest block 64 KB, more than our RAM */
+#define TLSF_FL_COUNT		(TLSF_FL_MAX - TLSF_FL_SHIFT + 1)
+#define TLSF_SMALL_BLOCK	(1 << TLSF_FL_SHIFT)
+
+typedef struct tlsf_block {
+	struct tlsf_block *prev_phys;	/* only valid while the previous block is free */
+	size_t size;			/* payload bytes, low bits are flags */
+	struct tlsf_block *next_free;	/* only valid while this block is free */
+	struct tlsf_block *prev_free;
+} tlsf_block_t;
+
+typedef struct tlsf_stats {
+	size_t pool_bytes;
+	size_t used_bytes;
+	size_t peak_used_bytes;
+	size_t free_bytes;
+	size_t largest_free;
+	unsigned int free_blocks;
+	unsigned int fragmentation;	/* per mille of free space outside the largest free block */
+	unsigned int allocs;
+	unsigned int frees;
+	unsigned int failures;
+} tlsf_stats_t;
+
+typedef struct tlsf {
+	tlsf_block_t null_block;	/* end of every free list */
+	unsigned int fl_bitmap;
+	unsigned int sl_bitmap[TLSF_FL_COUNT];
+	tlsf_block_t *blocks[TLSF_FL_COUNT][TLSF_SL_COUNT];
+	void *pool;
+	tlsf_stats_t stats;
+} tlsf_t;
+
+void tlsf_init(tlsf_t *tlsf, void *pool, size_t bytes);
+void *tlsf_malloc(tlsf_t *tlsf, size_t size);
+void tlsf_free(tlsf_t *tlsf, void *ptr);
+
+/* Walks the pool to fill in the free space figures, not O(1) */
+void tlsf_get_stats(tlsf_t *tlsf, tlsf_stats_t *stats);
+
+#endif
@@ -0,0 +1,201 @@
+#include "uring.h"
+#include "task_order.h"
+
+/* Tasks with a SLEEP outstanding, earliest first */
+static xTask *sleepers;
+
+void uring_init(struct uring *ring)
+{
+	ring->sq_head = ring->sq_tail = 0;
+	ring->cq_head = ring->cq_tail = 0;
+	ring->cq_overflow = 0;
+}
+
+/* Queue one operation, returns -1 when the submission ring is full */
+int uring_prep(struct uring *ring, URING_OP opcode, unsigned int task,
+               unsigned int arg, unsigned int user_data)
+{
+	struct uring_sqe *sqe;
+
+	if (ring->sq_tail - ring->sq_head == URING_ENTRIES)
+		return -1;
+	sqe = &ring->sq[ring->sq_tail & (URING_ENTRIES - 1)];
+	sqe->opcode = opcode;
+	sqe->task = task;
+	sqe->arg = arg;
+	sqe->user_data = user_data;
+	ring->sq_tail++;
+	return 0;
+}
+
+/* Pop one completion, returns 0 when the completion ring is empty */
+int uring_peek_cqe(struct uring *ring, struct uring_cqe *cqe)
+{
+	if (ring->cq_head == ring->cq_tail)
+		return 0;
+	*cqe = ring->cq[ring->cq_head & (URING_ENTRIES - 1)];
+	ring->cq_head++;
+	return 1;
+}
+
+static unsigned int cq_space(struct uring *ring)
+{
+	return URING_ENTRIES - (ring->cq_tail - ring->cq_head);
+}
+
+/* Post a completion and wake the owner once it has as many as it waits for */
+static void post_cqe(xTask *task, unsigned int user_data, int res)
+{
+	struct uring *ring = task->ring;
+	struct uring_cqe *cqe;
+
+	if (!ring)
+		return;
+	if (cq_space(ring)) {
+		cqe = &ring->cq[ring->cq_tail & (URING_ENTRIES - 1)];
+		cqe->user_data = user_data;
+		cqe->res = res;
+		ring->cq_tail++;
+	} else {
+		ring->cq_overflow++;
+	}
+
+	/* a dropped completion still counts, or the wait could never end */
+	if (task->state == WAITING && task->wait_nr) {
+		task->wait_nr--;
+		if (!task->wait_nr)
+			task_wake(task);
+	}
+}
+
+static int op_send(struct uring_sqe *sqe)
+{
+	xTask *dst;
+
+	if (sqe->task >= nr_tasks)
+		return URING_EINVAL;
+	dst = &user_task[sqe->task];
+
+	/* hand the word straight to an outstanding RECV */
+	if (dst->recv_pending) {
+		dst->recv_pending = 0;
+		post_cqe(dst, dst->recv_user_data, sqe->arg);
+		return URING_OK;
+	}
+	if (dst->mailbox_tail - dst->mailbox_head == MAILBOX_SIZE)
+		return URING_EFULL;
+	dst->mailbox[dst->mailbox_tail & (MAILBOX_SIZE - 1)] = sqe->arg;
+	dst->mailbox_tail++;
+	return URING_OK;
+}
+
+/* Returns 1 when the operation has completed with *res */
+static int op_recv(xTask *task, struct uring_sqe *sqe, int *res)
+{
+	if (task->mailbox_head != task->mailbox_tail) {
+		*res = task->mailbox[task->mailbox_head & (MAILBOX_SIZE - 1)];
+		task->mailbox_head++;
+		return 1;
+	}
+	if (task->recv_pending) {
+		*res = URING_EBUSY;
+		return 1;
+	}
+	task->recv_pending = 1;
+	task->recv_user_data = sqe->user_data;
+	return 0;
+}
+
+static int op_sleep(xTask *task, struct uring_sqe *sqe, int *res)
+{
+	if (task->sleep_pending) {
+		*res = URING_EBUSY;
+		return 1;
+	}
+	task->sleep_pending = 1;
+	task->sleep_tick = os_ticks + sqe->arg;
+	task->sleep_user_data = sqe->user_data;
+	TICK_LIST_INSERT(&sleepers, task, sleep_tick, sleep_next);
+	return 0;
+}
+
+static int op_signal(struct uring_sqe *sqe)
+{
+	xTask *dst;
+
+	if (sqe->task >= nr_tasks)
+		return URING_EINVAL;
+	dst = &user_task[sqe->task];
+	if (!dst->ring || !cq_space(dst->ring))
+		return URING_EFULL;
+	post_cqe(dst, sqe->user_data, sqe->arg);
+	return URING_OK;
+}
+
+/*
+ * Handle a uring_enter() trap: consume every queued submission, then block
+ * the caller until wait_nr completions are available. Stops early when the
+ * completion ring has no room left for an immediate result. Returns the
+ * number of submissions consumed.
+ */
+int uring_submit(xTask *task, struct uring *ring, unsigned int wait_nr)
+{
+	struct uring_sqe *sqe;
+	unsigned int ready;
+	int submitted = 0;
+	int res;
+	int done;
+
+	task->ring = ring;
+	while (ring->sq_head != ring->sq_tail && cq_space(ring)) {
+		sqe = &ring->sq[ring->sq_head & (URING_ENTRIES - 1)];
+		done = 1;
+		switch (sqe->opcode) {
+		case URING_OP_NOP:
+			res = URING_OK;
+			break;
+		case URING_OP_SEND:
+			res = op_send(sqe);
+			break;
+		case URING_OP_RECV:
+			done = op_recv(task, sqe, &res);
+			break;
+		case URING_OP_SLEEP:
+			done = op_sleep(task, sqe, &res);
+			break;
+		case URING_OP_SIGNAL:
+			res = op_signal(sqe);
+			break;
+		default:
+			res = URING_EINVAL;
+			break;
+		}
+		if (done)
+			post_cqe(task, sqe->user_data, res);
+		ring->sq_head++;
+		submitted++;
+	}
+
+	/* the ring holds URING_ENTRIES completions at most, waiting for more
+	 * would never end */
+	if (wait_nr > URING_ENTRIES)
+		wait_nr = URING_ENTRIES;
+	ready = ring->cq_tail - ring->cq_head;
+	if (wait_nr > ready && task->state == READY) {
+		task->wait_nr = wait_nr - ready;
+		task->state = WAITING;
+	}
+	return submitted;
+}
+
+/* Complete expired SLEEPs, called once per scheduler pass */
+void uring_poll(void)
+{
+	xTask *task;
+
+	while ((task = sleepers) && (int) (os_ticks - task->sleep_tick) >= 0) {
+		sleepers = task->sleep_next;
+		task->sleep_pending = 0;
+		post_cqe(task, task->sleep_user_data, URING_OK);
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef __URING_H_
+#define __URING_H_
+
+#include "os.h"
+
+/*
+ * Syscall batching in the spirit of io_uring: a task queues operations in
+ * the submission ring and hands all of them to the kernel with one
+ * uring_enter() trap. Results come back in the completion ring, tagged with
+ * the user_data of the submission. Operations that cannot finish right away
+ * (RECV on an empty mailbox, SLEEP) complete later, from another task's
+ * submission or from the scheduler.
+ *
+ * The kernel only reads sq_tail and writes sq_head, the task the other way
+ * round; likewise for the completion ring.
+ *
+ * uring_enter() waits for at most URING_ENTRIES completions, a larger
+ * wait_nr is clamped. A completion dropped on a full ring is counted in
+ * cq_overflow and still counts toward the wait.
+ */
+
+/* Entries in each ring, power of two */
+#define URING_ENTRIES	8
+
+/* Completion results */
+#define URING_OK	0
+#define URING_EINVAL	(-1)	/* bad opcode or task number */
+#define URING_EFULL	(-2)	/* destination mailbox or completion ring is full */
+#define URING_EBUSY	(-3)	/* only one RECV or SLEEP may be outstanding */
+
+typedef enum URING_OP {
+	URING_OP_NOP,
+	URING_OP_SEND,		/* post arg to the mailbox of task */
+	URING_OP_RECV,		/* complete with the next word of our mailbox */
+	URING_OP_SLEEP,		/* complete after arg ticks */
+	URING_OP_SIGNAL		/* post a completion carrying arg into the ring of task */
+} URING_OP;
+
+struct uring_sqe {
+	unsigned int opcode;
+	unsigned int task;
+	unsigned int arg;
+	unsigned int user_data;
+};
+
+struct uring_cqe {
+	unsigned int user_data;
+	int res;
+};
+
+struct uring {
+	volatile unsigned int sq_head;
+	volatile unsigned int sq_tail;
+	volatile unsigned int cq_head;
+	volatile unsigned int cq_tail;
+	unsigned int cq_overflow;	/* completions dropped on a full ring */
+	struct uring_sqe sq[URING_ENTRIES];
+	struct uring_cqe cq[URING_ENTRIES];
+};
+
+/* Task side, no trap involved except in uring_enter() */
+void uring_init(struct uring *ring);
+int uring_prep(struct uring *ring, URING_OP opcode, unsigned int task,
+               unsigned int arg, unsigned int user_data);
+int uring_peek_cqe(struct uring *ring, struct uring_cqe *cqe);
+
+/* Kernel side */
+int uring_submit(xTask *task, struct uring *ring, unsigned int wait_nr);
+void uring_poll(void);
+
+#endif
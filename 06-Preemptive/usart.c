@@ -0,0 +1,210 @@
+#include <stdint.h>
+#include "reg.h"
+#include "clock.h"
+#include "notify.h"
+#include "nvic.h"
+#include "usart.h"
+
+#define USART_FLAG_PE		((uint32_t) 0x00000001)
+#define USART_FLAG_FE		((uint32_t) 0x00000002)
+#define USART_FLAG_NE		((uint32_t) 0x00000004)
+#define USART_FLAG_ORE		((uint32_t) 0x00000008)
+#define USART_FLAG_RXNE		((uint32_t) 0x00000020)
+#define USART_FLAG_TC		((uint32_t) 0x00000040)
+/* USART TXE Flag
+ * This flag is cleared when data is written to USARTx_DR and
+ * set when that data is transferred to the TDR
+ */
+#define USART_FLAG_TXE		((uint32_t) 0x00000080)
+
+#define USART_CR1_RE		((uint32_t) 0x00000004)
+#define USART_CR1_RXNEIE	((uint32_t) 0x00000020)
+#define USART_CR1_TE		((uint32_t) 0x00000008)
+#define USART_CR1_UE		((uint32_t) 0x00002000)
+
+struct usart_stats usart_stats;
+
+static unsigned int requested_baud = USART_BAUD;
+static unsigned int brr;
+
+/* Written by the RX interrupt only */
+static volatile unsigned int rx_head;
+/* Written by the reader only */
+static volatile unsigned int rx_tail;
+static char rx_ring[USART_RX_SIZE];
+static unsigned int rx_task = -1;
+
+void usart_init(unsigned int baud)
+{
+	*(RCC_APB2ENR) |= (uint32_t)(0x00000001 | 0x00000004);
+	*(RCC_APB1ENR) |= (uint32_t)(0x00020000);
+
+	/* USART2 Configuration, Rx->PA3, Tx->PA2 */
+	*(GPIOA_CRL) = 0x00004B00;
+	*(GPIOA_CRH) = 0x44444444;
+	*(GPIOA_ODR) = 0x00000000;
+	*(GPIOA_BSRR) = 0x00000000;
+	*(GPIOA_BRR) = 0x00000000;
+
+	*(USART2_CR1) = USART_CR1_TE | USART_CR1_RE | USART_CR1_RXNEIE;
+	*(USART2_CR2) = 0x00000000;
+	*(USART2_CR3) = 0x00000000;
+
+	/* a rate out of reach of the boot clock is retried on the next switch */
+	requested_baud = baud;
+	usart_set_baud(baud);
+	*(USART2_CR1) |= USART_CR1_UE;
+
+	/* the handler wakes the reader, so it runs at kernel level */
+	nvic_set_priority(USART2_IRQn, IRQ_PRIO_KERNEL);
+	nvic_enable_irq(USART2_IRQn);
+}
+
+/*
+ * BRR holds USARTDIV in 12.4 fixed point, and baud = PCLK1 / (16 * USARTDIV),
+ * so the register value is simply PCLK1 / baud, rounded to nearest.
+ */
+static unsigned int baud_divisor(unsigned int pclk1, unsigned int baud)
+{
+	return (pclk1 + baud / 2) / baud;
+}
+
+static unsigned int divisor_error(unsigned int pclk1, unsigned int div, unsigned int baud)
+{
+	unsigned int actual = pclk1 / div;
+
+	return (actual > baud ? actual - baud : baud - actual) * 1000 / baud;
+}
+
+int usart_set_baud(unsigned int baud)
+{
+	unsigned int pclk1 = clock_pclk1();
+	unsigned int div;
+
+	if (!baud)
+		return -1;
+	div = baud_divisor(pclk1, baud);
+	if (div < 16 || div > 0xFFFF || divisor_error(pclk1, div, baud) > USART_BAUD_TOLERANCE) {
+		usart_stats.baud_rejects++;
+		return -1;
+	}
+	usart_flush();
+	requested_baud = baud;
+	brr = div;
+	*(USART2_BRR) = div;
+	return 0;
+}
+
+unsigned int usart_baud(void)
+{
+	return requested_baud;
+}
+
+unsigned int usart_baud_error(void)
+{
+	return brr ? divisor_error(clock_pclk1(), brr, requested_baud) : 0;
+}
+
+/* PCLK1 just changed, the caller already flushed at the old rate */
+void usart_clock_changed(void)
+{
+	usart_set_baud(requested_baud);
+}
+
+void usart_putc(char c)
+{
+	if (!(*(USART2_SR) & USART_FLAG_TXE)) {
+		usart_stats.tx_stalls++;
+		while (!(*(USART2_SR) & USART_FLAG_TXE));
+	}
+	*(USART2_DR) = c & 0xFF;
+	usart_stats.tx_bytes++;
+}
+
+void usart_write(const char *str)
+{
+	while (*str)
+		usart_putc(*str++);
+}
+
+void usart_flush(void)
+{
+	while (!(*(USART2_SR) & USART_FLAG_TC));
+}
+
+void usart2_irq_handler(void)
+{
+	uint32_t sr = *(USART2_SR);
+	char c;
+
+	if (!(sr & (USART_FLAG_RXNE | USART_FLAG_ORE)))
+		return;
+	/* reading SR then DR also clears the error flags */
+	c = *(USART2_DR) & 0xFF;
+	if (sr & USART_FLAG_ORE)
+		usart_stats.rx_overruns++;
+	if (sr & (USART_FLAG_FE | USART_FLAG_NE | USART_FLAG_PE))
+		usart_stats.rx_errors++;
+	if (!(sr & USART_FLAG_RXNE))
+		return;
+	usart_stats.rx_bytes++;
+
+	if (rx_head - rx_tail == USART_RX_SIZE) {
+		usart_stats.rx_drops++;
+		return;
+	}
+	rx_ring[rx_head & (USART_RX_SIZE - 1)] = c;
+	rx_head++;
+	notify_give_from_isr(rx_task);
+}
+
+int usart_getc(void)
+{
+	int c;
+
+	if (rx_tail == rx_head)
+		return -1;
+	c = rx_ring[rx_tail & (USART_RX_SIZE - 1)];
+	rx_tail++;
+	return c;
+}
+
+void usart_rx_attach(unsigned int task)
+{
+	rx_task = task;
+}
+
+static int usart_getc_wait(void)
+{
+	int c;
+
+	while ((c = usart_getc()) < 0) {
+		if (rx_task < nr_tasks)
+			notify_take(1, NOTIFY_FOREVER);
+	}
+	return c;
+}
+
+int usart_readline(char *buf, unsigned int size)
+{
+	unsigned int len = 0;
+	int c;
+
+	while (1) {
+		c = usart_getc_wait();
+		if (c == '\r' || c == '\n') {
+			usart_write("\n");
+			buf[len] = '\0';
+			return len;
+		}
+		if (c == '\b' || c == 0x7F) {
+			if (len) {
+				len--;
+				usart_write("\b \b");
+			}
+		} else if (c >= ' ' && c < 0x7F && len + 1 < size) {
+			buf[len++] = c;
+			usart_putc(c);
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#ifndef __USART_H_
+#define __USART_H_
+
+/*
+ * USART2 driver, 8N1 on PA2 (TX) / PA3 (RX). The baud divisor is derived
+ * from the current PCLK1, and clock.c calls usart_clock_changed() after
+ * every profile switch so the line rate survives it. With 16x oversampling
+ * the fastest rate is PCLK1 / 16: 2.25 Mbaud at 36 MHz, 500 kbaud on the
+ * bare 8 MHz HSE.
+ *
+ * Received bytes are moved by the RX interrupt into a ring buffer, which
+ * has a single reader. A reader task registered with usart_rx_attach() is
+ * sent a notification per byte and sleeps in notify_take() meanwhile.
+ */
+
+#ifndef USART_BAUD
+#define USART_BAUD	115200
+#endif
+
+/* Bytes buffered between the RX interrupt and the reader, power of two */
+#define USART_RX_SIZE	64
+
+/* Largest accepted baud rate error, per mille */
+#define USART_BAUD_TOLERANCE	20
+
+struct usart_stats {
+	unsigned int tx_bytes;
+	unsigned int tx_stalls;		/* writes that found the data register still full */
+	unsigned int rx_bytes;
+	unsigned int rx_overruns;	/* bytes lost before the interrupt read them */
+	unsigned int rx_drops;		/* bytes lost to a full ring buffer */
+	unsigned int rx_errors;		/* framing and noise errors */
+	unsigned int baud_rejects;	/* rates out of reach of the current PCLK1 */
+};
+
+extern struct usart_stats usart_stats;
+
+void usart_init(unsigned int baud);
+
+/* Returns -1, leaving the divisor alone, when baud is out of reach */
+int usart_set_baud(unsigned int baud);
+unsigned int usart_baud(void);
+
+/* Rate error of the programmed divisor, per mille */
+unsigned int usart_baud_error(void);
+
+void usart_clock_changed(void);
+void usart_putc(char c);
+void usart_write(const char *str);
+
+/* Wait until the last byte has left the shift register */
+void usart_flush(void);
+
+/* Returns the next received byte, -1 when there is none */
+int usart_getc(void);
+
+/* Wake task `task` for every received byte */
+void usart_rx_attach(unsigned int task);
+
+/*
+ * Line discipline: assemble one line into buf, echoing what is typed and
+ * handling backspace. Blocks the attached reader until Enter, returns the
+ * line length without the terminator.
+ */
+int usart_readline(char *buf, unsigned int size);
+
+#endif
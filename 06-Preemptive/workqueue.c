@@ -0,0 +1,98 @@
+#include "atomic.h"
+#include "notify.h"
+#include "clock.h"
+#include "workqueue.h"
+
+struct workqueue_stats workqueue_stats;
+
+/* Newest first, the worker reverses each batch */
+static volatile unsigned int head;
+static unsigned int worker = -1;
+
+static unsigned int in_handler(void)
+{
+	unsigned int ipsr;
+
+	__asm__ __volatile__("mrs %0, ipsr" : "=r" (ipsr));
+	return ipsr;
+}
+
+int work_queue(struct work *work)
+{
+	struct workqueue_stats *st = &workqueue_stats;
+	unsigned int old, depth;
+
+	if (atomic_exchange(&work->pending, 1)) {
+		atomic_fetch_add(&st->coalesced, 1);
+		return 0;
+	}
+	work->queued_at = clock_now();
+	atomic_release();
+	do {
+		old = atomic_ldrex(&head);
+		work->next = (struct work *) old;
+	} while (atomic_strex(&head, (unsigned int) work));
+
+	atomic_fetch_add(&st->queued, 1);
+	depth = atomic_fetch_add(&st->depth, 1) + 1;
+	do {
+		old = st->max_depth;
+	} while (depth > old && atomic_cas(&st->max_depth, old, depth) != old);
+
+	if (in_handler())
+		notify_give_from_isr(worker);
+	else if (worker < nr_tasks)
+		notify_give(worker);
+	return 1;
+}
+
+void workqueue_attach(unsigned int task)
+{
+	worker = task;
+}
+
+static void run_batch(struct work *list)
+{
+	struct workqueue_stats *st = &workqueue_stats;
+	struct work *work, *next, *fifo = NULL;
+	unsigned int batch = 0;
+	unsigned int latency;
+
+	for (work = list; work; work = next) {
+		next = work->next;
+		work->next = fifo;
+		fifo = work;
+	}
+
+	for (work = fifo; work; work = next) {
+		next = work->next;
+		latency = clock_now() - work->queued_at;
+		st->latency_last = latency;
+		st->latency_avg += ((int) latency - (int) st->latency_avg) / 8;
+		if (latency > st->latency_max)
+			st->latency_max = latency;
+
+		atomic_store_release(&work->pending, 0);
+		work->func(work);
+		atomic_fetch_sub(&st->depth, 1);
+		batch++;
+	}
+
+	st->run += batch;
+	st->batches++;
+	if (batch > st->max_batch)
+		st->max_batch = batch;
+}
+
+void workqueue_task(void)
+{
+	unsigned int list;
+
+	while (1) {
+		notify_take(1, NOTIFY_FOREVER);
+		while ((list = atomic_exchange(&head, 0))) {
+			atomic_acquire();
+			run_batch((struct work *) list);
+		}
+	}
+}
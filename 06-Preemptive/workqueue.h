@@ -0,0 +1,52 @@
+#ifndef __WORKQUEUE_H_
+#define __WORKQUEUE_H_
+
+#include "os.h"
+
+/*
+ * Deferred work, for interrupt handlers that have more to do than they
+ * should do with interrupts held off. The handler fills in a struct work
+ * it owns and calls work_queue(), which pushes it on a lock-free list in
+ * O(1) and wakes the worker task. The worker runs at the highest task
+ * priority. It takes the whole list at once and runs the batch in queueing
+ * order, with every interrupt enabled.
+ *
+ * work_queue() works from kernel-level ISRs (see nvic.h), the kernel and
+ * tasks alike. A work item queued again before it ran is only run once.
+ * The pending flag is cleared just before the function is called, so the
+ * function may queue its item again.
+ */
+
+struct work {
+	void (*func)(struct work *work);
+	struct work *next;
+	volatile unsigned int pending;
+	unsigned int queued_at;		/* clock_now() when queued */
+};
+
+#define WORK_INIT(fn)	{ .func = (fn) }
+
+/* Latency figures are in core cycles */
+struct workqueue_stats {
+	unsigned int queued;
+	unsigned int coalesced;		/* queued again while still pending */
+	unsigned int run;
+	unsigned int batches;
+	unsigned int max_batch;
+	volatile unsigned int depth;	/* queued and not run yet */
+	volatile unsigned int max_depth;
+	unsigned int latency_last;
+	unsigned int latency_avg;	/* moving average over about 8 items */
+	unsigned int latency_max;
+};
+
+extern struct workqueue_stats workqueue_stats;
+
+/* Returns 1 when queued, 0 when the item was already pending */
+int work_queue(struct work *work);
+
+/* The worker, set up from main before the scheduler starts */
+void workqueue_attach(unsigned int task);
+void workqueue_task(void);
+
+#endif